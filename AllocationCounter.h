@@ -0,0 +1,61 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+// Replaces the global operator new and delete to count every heap allocation
+// of the binary, for the tests that a workspace makes a call allocation free.
+// The replacements are definitions: include this from one translation unit
+// only, the test's. They are not inlined: GCC would see the free() of an
+// inlined delete paired with a new and warn of a mismatch.
+std::atomic<long long> heapAllocations{0};
+
+__attribute__((noinline)) void* operator new(std::size_t size)
+{
+    ++heapAllocations;
+
+    if (void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+__attribute__((noinline)) void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+// used by the buffers of inplace_merge
+__attribute__((noinline)) void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    ++heapAllocations;
+    return std::malloc(size ? size : 1);
+}
+
+// used by new_delete_resource
+__attribute__((noinline)) void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    ++heapAllocations;
+
+    std::size_t a = static_cast<std::size_t>(alignment);
+    if (void* p = std::aligned_alloc(a, (std::max<std::size_t>(size, 1) + a - 1) / a * a))
+        return p;
+    throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void operator delete(void* p, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+
+__attribute__((noinline)) void operator delete(void* p, std::size_t, std::align_val_t) noexcept
+{
+    std::free(p);
+}
@@ -0,0 +1,388 @@
+#include "Point.h"
+#include "Util.h"
+
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+
+#include <gtest/gtest.h>
+
+
+using namespace std;
+
+double squaredDistance(const Point& p, const Point& q)
+{
+    Point d = p - q;
+    return d & d;
+}
+
+void closestPairRecursive(vector<Point>& points, int lo, int hi, vector<Point>& buffer, pair<Point, Point>& closest, double& bestSquared)
+{
+    auto byY = [](const Point& p1, const Point& p2) {
+        return p1.y < p2.y;
+    };
+
+    if (hi - lo <= 3)
+    {
+        for (int i = lo; i < hi; ++i)
+        {
+            for (int j = i + 1; j < hi; ++j)
+            {
+                double d = squaredDistance(points[i], points[j]);
+                if (d < bestSquared)
+                {
+                    bestSquared = d;
+                    closest = {points[i], points[j]};
+                }
+            }
+        }
+
+        sort(points.begin() + lo, points.begin() + hi, byY);
+        return;
+    }
+
+    int mid = (lo + hi) / 2;
+    double midX = points[mid].x;
+
+    closestPairRecursive(points, lo, mid, buffer, closest, bestSquared);
+    closestPairRecursive(points, mid, hi, buffer, closest, bestSquared);
+
+    // both halves come back sorted by y; merge them so the strip is in y order
+    merge(points.begin() + lo, points.begin() + mid, points.begin() + mid, points.begin() + hi, buffer.begin(), byY);
+    copy(buffer.begin(), buffer.begin() + (hi - lo), points.begin() + lo);
+
+    int stripSize = 0;
+    for (int i = lo; i < hi; ++i)
+    {
+        double dx = points[i].x - midX;
+        if (dx * dx >= bestSquared)
+            continue;
+
+        for (int j = stripSize - 1; j >= 0; --j)
+        {
+            double dy = points[i].y - buffer[j].y;
+            if (dy * dy >= bestSquared)
+                break;
+
+            double d = squaredDistance(points[i], buffer[j]);
+            if (d < bestSquared)
+            {
+                bestSquared = d;
+                closest = {buffer[j], points[i]};
+            }
+        }
+
+        buffer[stripSize++] = points[i];
+    }
+}
+
+// O(n * log(n)). Returns the smallest distance between two input points, or
+// infinity for fewer than two points.
+double closestPairDivideAndConquer(const vector<Point>& points, pair<Point, Point>& closest)
+{
+    double bestSquared = numeric_limits<double>::infinity();
+    if (points.size() < 2)
+        return bestSquared;
+
+    vector<Point> sorted = points;
+    lexicographicSort(sorted);
+
+    vector<Point> buffer(sorted.size());
+    closestPairRecursive(sorted, 0, sorted.size(), buffer, closest, bestSquared);
+
+    return sqrt(bestSquared);
+}
+
+// Cells are packed into one 64 bit key; wrapped coordinates only make two far
+// apart cells share a bucket, which costs time but never correctness.
+uint64_t cellKey(int64_t cx, int64_t cy)
+{
+    return (static_cast<uint64_t>(static_cast<uint32_t>(cx)) << 32) | static_cast<uint32_t>(cy);
+}
+
+int64_t cellCoordinate(double v, double cellSize)
+{
+    return static_cast<int64_t>(floor(v / cellSize));
+}
+
+// Expected O(n): points are inserted in random order into a grid of cell size
+// delta = current closest distance. A point closer than delta must lie in the
+// 3x3 cells around it; when one is found, delta shrinks and the grid is rebuilt,
+// which happens at step i with probability at most 2 / i.
+double closestPairGrid(const vector<Point>& points, pair<Point, Point>& closest, unsigned seed = 0)
+{
+    double best = numeric_limits<double>::infinity();
+    if (points.size() < 2)
+        return best;
+
+    vector<int> order(points.size());
+    iota(order.begin(), order.end(), 0);
+    shuffle(order.begin(), order.end(), mt19937(seed));
+
+    unordered_map<uint64_t, int> head;
+    vector<int> next(points.size(), -1);
+
+    auto insert = [&](int i) {
+        const auto& p = points[order[i]];
+        auto key = cellKey(cellCoordinate(p.x, best), cellCoordinate(p.y, best));
+
+        auto it = head.find(key);
+        next[i] = it == head.end() ? -1 : it->second;
+        head[key] = i;
+    };
+
+    auto rebuild = [&](int count) {
+        head.clear();
+        head.reserve(2 * count);
+        for (int i = 0; i < count; ++i)
+            insert(i);
+    };
+
+    best = sqrt(squaredDistance(points[order[0]], points[order[1]]));
+    closest = {points[order[0]], points[order[1]]};
+
+    if (best == 0.)
+        return best;
+
+    rebuild(2);
+
+    for (int i = 2; i < order.size(); ++i)
+    {
+        const auto& p = points[order[i]];
+        int64_t cx = cellCoordinate(p.x, best);
+        int64_t cy = cellCoordinate(p.y, best);
+
+        double nearestSquared = best * best;
+        int nearest = -1;
+
+        for (int64_t dx = -1; dx <= 1; ++dx)
+        {
+            for (int64_t dy = -1; dy <= 1; ++dy)
+            {
+                auto it = head.find(cellKey(cx + dx, cy + dy));
+                if (it == head.end())
+                    continue;
+
+                for (int j = it->second; j >= 0; j = next[j])
+                {
+                    double d = squaredDistance(p, points[order[j]]);
+                    if (d < nearestSquared)
+                    {
+                        nearestSquared = d;
+                        nearest = j;
+                    }
+                }
+            }
+        }
+
+        if (nearest < 0)
+        {
+            insert(i);
+            continue;
+        }
+
+        best = sqrt(nearestSquared);
+        closest = {points[order[nearest]], p};
+
+        if (best == 0.)
+            return best;
+
+        rebuild(i + 1);
+    }
+
+    return best;
+}
+
+// Appends every pair (i, j), i < j, with |points[i] - points[j]| <= d, sorted.
+// Points are bucketed into cells of size d; each cell is compared with itself
+// and four of its neighbours so every pair is seen once. Cells are split into
+// contiguous chunks across nThreads workers whose outputs are concatenated in
+// order, so the result does not depend on the thread count.
+void pairsWithinDistance(const vector<Point>& points, double d, vector<pair<int, int>>& pairs, int nThreads = 1)
+{
+    if (points.empty() || d < 0.)
+        return;
+
+    TRACE_SPAN("pairsWithinDistance");
+    STATS_PHASE("grid");
+
+    // d == 0 only matches coincident points; any positive cell size works
+    double cellSize = d > 0. ? d : 1.;
+    double dSquared = d * d;
+
+    struct CellEntry
+    {
+        int64_t cx, cy;
+        int id;
+    };
+
+    vector<CellEntry> entries(points.size());
+    for (int i = 0; i < points.size(); ++i)
+        entries[i] = {cellCoordinate(points[i].x, cellSize), cellCoordinate(points[i].y, cellSize), i};
+
+    sort(entries.begin(), entries.end(), [](const CellEntry& e1, const CellEntry& e2) {
+        if (e1.cx != e2.cx)
+            return e1.cx < e2.cx;
+        if (e1.cy != e2.cy)
+            return e1.cy < e2.cy;
+        return e1.id < e2.id;
+    });
+
+    // cellStart[c] .. cellStart[c + 1] are the entries of the c-th occupied cell
+    vector<int> cellStart;
+    for (int i = 0; i < entries.size(); ++i)
+        if (i == 0 || entries[i].cx != entries[i - 1].cx || entries[i].cy != entries[i - 1].cy)
+            cellStart.push_back(i);
+    int nCells = cellStart.size();
+    cellStart.push_back(entries.size());
+
+    auto findCell = [&](int64_t cx, int64_t cy) {
+        auto it = lower_bound(cellStart.begin(), cellStart.end() - 1, 0, [&](int start, int) {
+            const auto& e = entries[start];
+            return e.cx < cx || (e.cx == cx && e.cy < cy);
+        });
+
+        int c = it - cellStart.begin();
+        if (c < nCells && entries[cellStart[c]].cx == cx && entries[cellStart[c]].cy == cy)
+            return c;
+        return -1;
+    };
+
+    auto processCells = [&](int firstCell, int lastCell, vector<pair<int, int>>& out) {
+        TRACE_SPAN("cells");
+
+        const int64_t neighbours[4][2] = { {0, 1}, {1, -1}, {1, 0}, {1, 1} };
+
+        for (int c = firstCell; c < lastCell; ++c)
+        {
+            for (int a = cellStart[c]; a < cellStart[c + 1]; ++a)
+            {
+                for (int b = a + 1; b < cellStart[c + 1]; ++b)
+                {
+                    if (squaredDistance(points[entries[a].id], points[entries[b].id]) <= dSquared)
+                        out.push_back(minmax(entries[a].id, entries[b].id));
+                }
+            }
+
+            for (const auto& offset : neighbours)
+            {
+                int n = findCell(entries[cellStart[c]].cx + offset[0], entries[cellStart[c]].cy + offset[1]);
+                if (n < 0)
+                    continue;
+
+                for (int a = cellStart[c]; a < cellStart[c + 1]; ++a)
+                {
+                    for (int b = cellStart[n]; b < cellStart[n + 1]; ++b)
+                    {
+                        if (squaredDistance(points[entries[a].id], points[entries[b].id]) <= dSquared)
+                            out.push_back(minmax(entries[a].id, entries[b].id));
+                    }
+                }
+            }
+        }
+    };
+
+    STATS_NEXT_PHASE("pairs");
+
+    nThreads = max(1, min(nThreads, nCells));
+    vector<vector<pair<int, int>>> partial(nThreads);
+    vector<thread> workers;
+
+    for (int t = 0; t < nThreads; ++t)
+    {
+        int firstCell = static_cast<long long>(nCells) * t / nThreads;
+        int lastCell = static_cast<long long>(nCells) * (t + 1) / nThreads;
+
+        if (t + 1 == nThreads)
+            processCells(firstCell, lastCell, partial[t]);
+        else
+            workers.emplace_back(processCells, firstCell, lastCell, ref(partial[t]));
+    }
+
+    for (auto& worker : workers)
+        worker.join();
+
+    STATS_NEXT_PHASE("merge");
+
+    auto first = pairs.size();
+    for (const auto& part : partial)
+        pairs.insert(pairs.end(), part.begin(), part.end());
+
+    sort(pairs.begin() + first, pairs.end());
+}
+
+double closestPairNaive(const vector<Point>& points)
+{
+    double best = numeric_limits<double>::infinity();
+
+    for (int i = 0; i < points.size(); ++i)
+        for (int j = i + 1; j < points.size(); ++j)
+            best = min(best, sqrt(squaredDistance(points[i], points[j])));
+
+    return best;
+}
+
+
+TEST(closestPair, simple)
+{
+    vector<Point> input = { {1.1,1.2}, {-2,4}, {-3,12}, {4,-16}, {12,8}, {1.5, 1.5}};
+
+    pair<Point, Point> closest;
+
+    EXPECT_DOUBLE_EQ(closestPairDivideAndConquer(input, closest), 0.5);
+    EXPECT_TRUE((closest == pair<Point, Point>{{1.1, 1.2}, {1.5, 1.5}}) || (closest == pair<Point, Point>{{1.5, 1.5}, {1.1, 1.2}}));
+
+    EXPECT_DOUBLE_EQ(closestPairGrid(input, closest), 0.5);
+    EXPECT_TRUE((closest == pair<Point, Point>{{1.1, 1.2}, {1.5, 1.5}}) || (closest == pair<Point, Point>{{1.5, 1.5}, {1.1, 1.2}}));
+
+    vector<pair<int, int>> pairs;
+    pairsWithinDistance(input, 5., pairs);
+
+    vector<pair<int, int>> expected = { {0, 1}, {0, 5}, {1, 5} };
+    EXPECT_TRUE(pairs == expected);
+
+    vector<Point> duplicates = { {0, 0}, {1, 1}, {0, 0} };
+    EXPECT_EQ(closestPairDivideAndConquer(duplicates, closest), 0.);
+    EXPECT_EQ(closestPairGrid(duplicates, closest), 0.);
+}
+
+TEST(closestPair, random)
+{
+    mt19937 gen(42);
+    uniform_real_distribution<double> coordinate(-100., 100.);
+
+    for (int n : {2, 3, 10, 100, 2000})
+    {
+        vector<Point> points(n);
+        for (auto& p : points)
+            p = {coordinate(gen), coordinate(gen)};
+
+        pair<Point, Point> closest;
+        double expected = closestPairNaive(points);
+
+        EXPECT_DOUBLE_EQ(closestPairDivideAndConquer(points, closest), expected);
+        EXPECT_DOUBLE_EQ(sqrt(squaredDistance(closest.first, closest.second)), expected);
+
+        EXPECT_DOUBLE_EQ(closestPairGrid(points, closest, n), expected);
+        EXPECT_DOUBLE_EQ(sqrt(squaredDistance(closest.first, closest.second)), expected);
+
+        vector<pair<int, int>> expectedPairs;
+        for (int i = 0; i < n; ++i)
+            for (int j = i + 1; j < n; ++j)
+                if (squaredDistance(points[i], points[j]) <= 25.)
+                    expectedPairs.push_back({i, j});
+
+        vector<pair<int, int>> sequential, parallel;
+        pairsWithinDistance(points, 5., sequential);
+        pairsWithinDistance(points, 5., parallel, 4);
+
+        EXPECT_TRUE(sequential == expectedPairs);
+        EXPECT_TRUE(parallel == expectedPairs);
+    }
+}
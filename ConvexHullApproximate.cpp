@@ -0,0 +1,321 @@
+#include "Point.h"
+#include "Util.h"
+
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <cmath>
+
+#include <gtest/gtest.h>
+
+
+using namespace std;
+
+// Lowest and highest point of a strip.
+template <typename T>
+struct Strip
+{
+    BasicPoint<T> low, high;
+    bool empty = true;
+
+    void add(const BasicPoint<T>& p)
+    {
+        if (empty || p.y < low.y)
+            low = p;
+        if (empty || p.y > high.y)
+            high = p;
+        empty = false;
+    }
+
+    void add(const Strip& s)
+    {
+        if (!s.empty)
+        {
+            add(s.low);
+            add(s.high);
+        }
+    }
+};
+
+// Lowest and highest points at the smallest and at the largest x.
+template <typename T>
+struct Extremes
+{
+    Strip<T> left, right;
+
+    void add(const BasicPoint<T>& p)
+    {
+        if (left.empty || p.x < left.low.x)
+            left.empty = true;
+        if (left.empty || p.x == left.low.x)
+            left.add(p);
+
+        if (right.empty || p.x > right.low.x)
+            right.empty = true;
+        if (right.empty || p.x == right.low.x)
+            right.add(p);
+    }
+
+    void add(const Extremes& e)
+    {
+        for (const auto* s : {&e.left, &e.right})
+        {
+            if (!s->empty)
+            {
+                add(s->low);
+                add(s->high);
+            }
+        }
+    }
+};
+
+// Distance from p to the segment ab.
+template <typename T>
+double segmentDistance(const BasicPoint<T>& a, const BasicPoint<T>& b, const BasicPoint<T>& p)
+{
+    double dx = double(b.x) - a.x, dy = double(b.y) - a.y;
+    double px = double(p.x) - a.x, py = double(p.y) - a.y;
+
+    double length = dx * dx + dy * dy;
+    double t = length > 0. ? clamp((px * dx + py * dy) / length, 0., 1.) : 0.;
+
+    return hypot(px - t * dx, py - t * dy);
+}
+
+// How far p is outside of an x-monotone chain, measured to the edge above or
+// below it; chain runs left to right with the outside on the given side.
+template <typename T>
+double chainExcess(const vector<BasicPoint<T>>& chain, const BasicPoint<T>& p, eOrientation outside)
+{
+    auto j = upper_bound(chain.begin(), chain.end(), p.x, [](T x, const BasicPoint<T>& q) {
+        return x < q.x;
+    }) - chain.begin();
+
+    if (orientation(chain[j - 1], chain[j], p) != outside)
+        return 0.;
+
+    return segmentDistance(chain[j - 1], chain[j], p);
+}
+
+// Approximate hull of Bentley, Faust and Preparata for inputs too large for an
+// exact one. The x range is cut into strips no wider than epsilon and only the
+// lowest and highest point of each strip, plus those at the smallest and
+// largest x, go into the hull, so every point is at most one strip width from
+// it. hull gets a clockwise closed ring from the lowest leftmost vertex, like
+// convexHullBatch.
+//
+// Returns the achieved error: a bound on the distance of any point from the
+// hull, measured per point against the hull edge above or below it and capped
+// by the strip width. 0 means the hull is exact.
+//
+// Three passes over nThreads chunks on the shared pool: the x range and the
+// strips in O(n), the error in O(n * log(h)). O(nThreads * width / epsilon)
+// memory; there are never more strips than points, and epsilon <= 0 asks for
+// one strip per point.
+template <typename T>
+double convexHullApproximate(const vector<BasicPoint<T>>& points, double epsilon, vector<BasicPoint<T>>& hull, int nThreads = 1)
+{
+    TRACE_SPAN("convexHullApproximate");
+    STATS_PHASE("range");
+
+    hull.clear();
+
+    size_t n = points.size();
+    if (n == 0)
+        return 0.;
+
+    nThreads = static_cast<int>(max<size_t>(1, min<size_t>(max(nThreads, 1), n)));
+
+    vector<Extremes<T>> extremes(nThreads);
+    forRanges(n, nThreads, [&](size_t first, size_t last, int t) {
+        for (size_t i = first; i < last; ++i)
+            extremes[t].add(points[i]);
+    });
+
+    for (int t = 1; t < nThreads; ++t)
+        extremes[0].add(extremes[t]);
+
+    const auto& left = extremes[0].left;
+    const auto& right = extremes[0].right;
+
+    double xmin = left.low.x;
+    double width = double(right.low.x) - xmin;
+
+    size_t nStrips = 1;
+    if (width > 0.)
+        nStrips = epsilon > 0. ? static_cast<size_t>(min<double>(n, ceil(width / epsilon))) : n;
+
+    double stripWidth = width / nStrips;
+    double scale = width > 0. ? nStrips / width : 0.;
+
+    STATS_NEXT_PHASE("strips");
+    vector<vector<Strip<T>>> strips(nThreads);
+    forRanges(n, nThreads, [&](size_t first, size_t last, int t) {
+        TRACE_SPAN("strips");
+
+        auto& local = strips[t];
+        local.resize(nStrips);
+
+        for (size_t i = first; i < last; ++i)
+        {
+            size_t s = min(nStrips - 1, static_cast<size_t>((points[i].x - xmin) * scale));
+            local[s].add(points[i]);
+        }
+    });
+
+    for (int t = 1; t < nThreads; ++t)
+        for (size_t s = 0; s < nStrips; ++s)
+            strips[0][s].add(strips[t][s]);
+
+    STATS_NEXT_PHASE("hull");
+    vector<BasicPoint<T>> candidates = {left.low, left.high, right.low, right.high};
+    for (const auto& s : strips[0])
+    {
+        if (!s.empty)
+        {
+            candidates.push_back(s.low);
+            candidates.push_back(s.high);
+        }
+    }
+    strips.clear();
+
+    hull.resize(2 * candidates.size());
+    hull.resize(monotoneChainHull(candidates.data(), candidates.size(), hull.data()));
+
+    if (width == 0.)
+        return 0.;
+
+    // both chains left to right; the upper one ends at the rightmost vertex, the largest one
+    int r = max_element(hull.begin(), hull.end(), lexicographicLess<T>) - hull.begin();
+
+    vector<BasicPoint<T>> upper(hull.begin(), hull.begin() + r + 1);
+    vector<BasicPoint<T>> lower(hull.rbegin(), hull.rend() - r);
+
+    STATS_NEXT_PHASE("error");
+    vector<double> errors(nThreads, 0.);
+    forRanges(n, nThreads, [&](size_t first, size_t last, int t) {
+        TRACE_SPAN("error");
+
+        double error = 0.;
+        for (size_t i = first; i < last; ++i)
+        {
+            const auto& p = points[i];
+
+            // the vertical hull edges hold every point at the smallest and largest x
+            if (p.x <= left.low.x || p.x >= right.low.x)
+                continue;
+
+            double excess = max(chainExcess(upper, p, CCW), chainExcess(lower, p, CW));
+            error = max(error, min(excess, stripWidth));
+        }
+
+        errors[t] = error;
+    });
+
+    return *max_element(errors.begin(), errors.end());
+}
+
+
+// Distance from p to a clockwise closed ring, 0 inside.
+template <typename T>
+double hullDistance(const vector<BasicPoint<T>>& hull, const BasicPoint<T>& p)
+{
+    bool inside = true;
+    double distance = INFINITY;
+
+    for (int j = 0; j + 1 < hull.size(); ++j)
+    {
+        if (orientation(hull[j], hull[j + 1], p) == CCW)
+            inside = false;
+        distance = min(distance, segmentDistance(hull[j], hull[j + 1], p));
+    }
+
+    return inside ? 0. : distance;
+}
+
+TEST(convexHullApproximate, simple)
+{
+    vector<Point> points = { {1, 1}, {0, 2}, {0.5, 1.5}, {2, 0}, {0, 0}, {1.5, 0.2}, {2, 2}, {0, 1} };
+
+    vector<Point> hull;
+    EXPECT_EQ(convexHullApproximate(points, 0.5, hull), 0.);
+
+    vector<Point> expected = { {0, 0}, {0, 2}, {2, 2}, {2, 0}, {0, 0} };
+    EXPECT_TRUE(equal(hull.begin(), hull.end(), expected.begin(), expected.end(), samePoint<double>));
+
+    // one strip drops the lower of the two new points on top
+    points.push_back({0.5, 2.4});
+    points.push_back({1.5, 2.5});
+    double error = convexHullApproximate(points, 10., hull);
+
+    EXPECT_EQ(hull.size(), 6);
+    EXPECT_NEAR(error, segmentDistance(Point{0, 2}, Point{1.5, 2.5}, Point{0.5, 2.4}), 1e-12);
+
+    // one vertical line, one point, none
+    vector<Point> line = { {3, 1}, {3, -2}, {3, 0} };
+    EXPECT_EQ(convexHullApproximate(line, 0.1, hull), 0.);
+    EXPECT_EQ(hull.size(), 3);
+
+    EXPECT_EQ(convexHullApproximate(vector<Point>{{1, 1}}, 0.1, hull), 0.);
+    EXPECT_EQ(hull.size(), 2);
+
+    EXPECT_EQ(convexHullApproximate(vector<Point>(), 0.1, hull), 0.);
+    EXPECT_TRUE(hull.empty());
+}
+
+TEST(convexHullApproximate, random)
+{
+    mt19937 gen(47);
+    uniform_real_distribution<double> radius(0., 1.), angle(0., 2 * M_PI);
+
+    vector<Point> points(200000);
+    for (auto& p : points)
+    {
+        double r = sqrt(radius(gen)), a = angle(gen);
+        p = {5 * r * cos(a), 5 * r * sin(a)};
+    }
+
+    for (double epsilon : {1., 0.1, 0.01})
+    {
+        vector<Point> hull;
+        double error = convexHullApproximate(points, epsilon, hull, 4);
+
+        EXPECT_LE(error, epsilon);
+        EXPECT_LE(hull.size(), 2 * ceil(10 / epsilon) + 5);
+        ASSERT_TRUE(isConvexRingOf(points.data(), points.data() + points.size(), hull, false));
+
+        for (int i = 0; i < points.size(); i += 37)
+            ASSERT_LE(hullDistance(hull, points[i]), error + 1e-12);
+
+        vector<Point> hull1;
+        EXPECT_EQ(convexHullApproximate(points, epsilon, hull1, 1), error);
+        EXPECT_TRUE(equal(hull.begin(), hull.end(), hull1.begin(), hull1.end(), samePoint<double>));
+    }
+}
+
+TEST(convexHullApproximate, integer)
+{
+    mt19937 gen(53);
+    uniform_int_distribution<int> coordinate(-1000, 1000);
+
+    vector<BasicPoint<int32_t>> points(20000);
+    for (auto& p : points)
+        p = {coordinate(gen), coordinate(gen) / 4};
+
+    // a strip per distinct x is exact
+    vector<BasicPoint<int32_t>> hull;
+    EXPECT_EQ(convexHullApproximate(points, 0.5, hull, 3), 0.);
+
+    auto sorted = points;
+    vector<BasicPoint<int32_t>> exact(2 * sorted.size());
+    exact.resize(monotoneChainHull(sorted.data(), sorted.size(), exact.data()));
+
+    EXPECT_TRUE(hull == exact);
+
+    double error = convexHullApproximate(points, 300., hull, 3);
+    EXPECT_LE(error, 300.);
+    ASSERT_TRUE(isConvexRingOf(points.data(), points.data() + points.size(), hull, false));
+
+    for (const auto& p : points)
+        ASSERT_LE(hullDistance(hull, p), error + 1e-9);
+}
@@ -0,0 +1,278 @@
+#include "Point.h"
+#include "Util.h"
+#include "SmallHull.h"
+
+#include <vector>
+#include <algorithm>
+#include <random>
+
+#include <gtest/gtest.h>
+
+
+using namespace std;
+
+// Hulls of many small point sets in one call. Set i is
+// points[offsets[i] .. offsets[i + 1]) and its hull is written to
+// hulls[hullOffsets[i] .. hullOffsets[i + 1]) as a clockwise closed ring
+// without collinear vertices, started by rotateClockwiseRing: the ring a
+// single call of the hull functions gives. An empty set has an empty hull.
+//
+// The sets are cut into nThreads chunks of about the same number of points,
+// run on the shared pool.
+// Sets of at most SmallHullMax points go to the fixed size kernels; each
+// worker sorts a larger set in one scratch buffer sized for its largest set and
+// writes the ring to the slot of the set in hulls, which has room for
+// n + 1 points per set; the slots are then compacted. Memory is only
+// allocated when a buffer grows, so calls reusing the output vectors do not
+// allocate per set.
+template <typename T>
+void convexHullBatch(const vector<BasicPoint<T>>& points, const vector<int>& offsets, vector<BasicPoint<T>>& hulls, vector<int>& hullOffsets, int nThreads = 1)
+{
+    TRACE_SPAN("convexHullBatch");
+
+    int nSets = max<int>(0, offsets.size() - 1);
+
+    hullOffsets.resize(nSets + 1);
+    hullOffsets[0] = 0;
+
+    if (nSets == 0)
+    {
+        hulls.clear();
+        return;
+    }
+
+    hulls.resize(offsets[nSets] - offsets[0] + nSets);
+
+    // slot of set i starts at offsets[i] - offsets[0] + i; hullOffsets[i + 1]
+    // holds its length for now
+    auto worker = [&](int firstSet, int lastSet) {
+        TRACE_SPAN("hulls");
+
+        int largest = 0;
+        for (int i = firstSet; i < lastSet; ++i)
+            largest = max(largest, offsets[i + 1] - offsets[i]);
+
+        vector<BasicPoint<T>> scratch(3 * largest);
+        auto* sorted = scratch.data();
+        auto* chain = scratch.data() + largest;
+
+        for (int i = firstSet; i < lastSet; ++i)
+        {
+            int n = offsets[i + 1] - offsets[i];
+
+            int k;
+            if (n <= SmallHullMax)
+            {
+                k = smallConvexHull(points.data() + offsets[i], n, chain);
+            }
+            else
+            {
+                copy(points.begin() + offsets[i], points.begin() + offsets[i + 1], sorted);
+                k = monotoneChainHull(sorted, n, chain);
+            }
+
+            if (k > 0)
+            {
+                rotateClockwiseRing(chain, k - 1);
+                chain[k - 1] = chain[0];
+            }
+
+            copy(chain, chain + k, hulls.begin() + offsets[i] - offsets[0] + i);
+            hullOffsets[i + 1] = k;
+        }
+    };
+
+    forSetRanges(offsets, max(1, min(nThreads, nSets)), worker);
+
+    // slots only move towards the front
+    for (int i = 0; i < nSets; ++i)
+    {
+        int slot = offsets[i] - offsets[0] + i;
+        int length = hullOffsets[i + 1];
+
+        if (slot != hullOffsets[i])
+            copy(hulls.begin() + slot, hulls.begin() + slot + length, hulls.begin() + hullOffsets[i]);
+
+        hullOffsets[i + 1] = hullOffsets[i] + length;
+    }
+
+    hulls.resize(hullOffsets[nSets]);
+}
+
+
+TEST(convexHullBatch, simple)
+{
+    vector<Point> points = {
+        {1.1, 1.2}, {-2, 4}, {-3, 12}, {4, -16}, {12, 8},
+        {5, 5},
+        {0, 0}, {1, 1}, {2, 2}, {1, 1},
+        {0, 0}, {0, 2}, {2, 2}, {2, 0}, {1, 1}, {1, 0}, {0, 2}
+    };
+    vector<int> offsets = {0, 5, 6, 6, 10, 17};
+
+    vector<Point> hulls;
+    vector<int> hullOffsets;
+    convexHullBatch(points, offsets, hulls, hullOffsets);
+
+    EXPECT_TRUE((hullOffsets == vector<int>{0, 5, 7, 7, 10, 15}));
+
+    vector<Point> expected = {
+        {-2, 4}, {-3, 12}, {12, 8}, {4, -16}, {-2, 4},
+        {5, 5}, {5, 5},
+        {2, 2}, {0, 0}, {2, 2},
+        {0, 2}, {2, 2}, {2, 0}, {0, 0}, {0, 2}
+    };
+
+    EXPECT_TRUE(equal(hulls.begin(), hulls.end(), expected.begin(), expected.end(), samePoint<double>));
+}
+
+TEST(convexHullBatch, random)
+{
+    mt19937 gen(37);
+    uniform_int_distribution<int> size(0, 200);
+    normal_distribution<double> spread(0., 1.);
+
+    vector<Point> points;
+    vector<int> offsets = {0};
+    for (int i = 0; i < 2000; ++i)
+    {
+        int n = size(gen);
+        for (int j = 0; j < n; ++j)
+            points.push_back({i + spread(gen), spread(gen)});
+        offsets.push_back(points.size());
+    }
+
+    vector<Point> hulls;
+    vector<int> hullOffsets;
+    convexHullBatch(points, offsets, hulls, hullOffsets, 4);
+
+    ASSERT_EQ(hullOffsets.size(), offsets.size());
+
+    for (int i = 0; i + 1 < offsets.size(); ++i)
+    {
+        vector<Point> hull(hulls.begin() + hullOffsets[i], hulls.begin() + hullOffsets[i + 1]);
+
+        if (offsets[i] == offsets[i + 1])
+            ASSERT_TRUE(hull.empty());
+        else
+            ASSERT_TRUE(isConvexRingOf(points.data() + offsets[i], points.data() + offsets[i + 1], hull));
+    }
+
+    // the same with one thread and with reused buffers
+    auto hullOffsets4 = hullOffsets;
+    auto hulls4 = hulls;
+    convexHullBatch(points, offsets, hulls, hullOffsets, 1);
+
+    EXPECT_TRUE(hullOffsets4 == hullOffsets);
+    EXPECT_TRUE(equal(hulls4.begin(), hulls4.end(), hulls.begin(), hulls.end(), samePoint<double>));
+}
+
+TEST(convexHullBatch, integer)
+{
+    mt19937 gen(41);
+    uniform_int_distribution<int> coordinate(-3, 3);
+
+    // many duplicates and collinear points
+
+    vector<BasicPoint<int32_t>> points;
+    vector<int> offsets = {0};
+    for (int i = 0; i < 500; ++i)
+    {
+        for (int j = 0; j < 12; ++j)
+            points.push_back({coordinate(gen), coordinate(gen)});
+        offsets.push_back(points.size());
+    }
+
+    vector<BasicPoint<int32_t>> hulls;
+    vector<int> hullOffsets;
+    convexHullBatch(points, offsets, hulls, hullOffsets, 3);
+
+    for (int i = 0; i + 1 < offsets.size(); ++i)
+    {
+        vector<BasicPoint<int32_t>> hull(hulls.begin() + hullOffsets[i], hulls.begin() + hullOffsets[i + 1]);
+        ASSERT_TRUE(isConvexRingOf(points.data() + offsets[i], points.data() + offsets[i + 1], hull));
+    }
+}
+
+TEST(convexHullBatch, singleCall)
+{
+    mt19937 gen(47);
+    uniform_int_distribution<int> coordinate(-4, 4);
+
+    // each set as it is and repeated past SmallHullMax, which takes the
+    // generic path; both entries are the ring of a single call
+    vector<Point> points;
+    vector<int> offsets = {0};
+    vector<vector<Point>> expected;
+    for (int n = 1; n <= SmallHullMax; ++n)
+    {
+        for (int trial = 0; trial < 50; ++trial)
+        {
+            vector<Point> set(n);
+            for (auto& p : set)
+                p = {coordinate(gen) / 4., trial % 3 ? coordinate(gen) / 4. : 0.};
+
+            vector<Point> repeated;
+            while (repeated.size() <= SmallHullMax)
+                repeated.insert(repeated.end(), set.begin(), set.end());
+
+            for (const auto* s : {&set, &repeated})
+            {
+                points.insert(points.end(), s->begin(), s->end());
+                offsets.push_back(points.size());
+                expected.push_back(smallConvexHull(set));
+            }
+        }
+    }
+
+    vector<Point> hulls;
+    vector<int> hullOffsets;
+    convexHullBatch(points, offsets, hulls, hullOffsets, 3);
+
+    for (int i = 0; i < expected.size(); ++i)
+        ASSERT_TRUE(equal(hulls.begin() + hullOffsets[i], hulls.begin() + hullOffsets[i + 1], expected[i].begin(), expected[i].end(), samePoint<double>));
+}
+
+TEST(convexHullBatch, smallKernels)
+{
+    mt19937 gen(43);
+    uniform_int_distribution<int> coordinate(-4, 4);
+
+    // every size up to SmallHullMax against the generic chain, with duplicates and collinear points
+    for (int n = 1; n <= SmallHullMax; ++n)
+    {
+        for (int trial = 0; trial < 200; ++trial)
+        {
+            vector<BasicPoint<int32_t>> points(n);
+            for (auto& p : points)
+                p = {coordinate(gen), coordinate(gen) * (trial % 3 ? 1 : 0)};
+
+            BasicPoint<int32_t> ring[2 * SmallHullMax];
+            int k = smallConvexHull(points.data(), n, ring);
+
+            auto sorted = points;
+            vector<BasicPoint<int32_t>> chain(2 * n);
+            chain.resize(monotoneChainHull(sorted.data(), n, chain.data()));
+
+            ASSERT_TRUE(vector<BasicPoint<int32_t>>(ring, ring + k) == chain);
+        }
+    }
+
+    EXPECT_EQ(smallConvexHull<int32_t>(nullptr, 0, nullptr), 0);
+
+    // the network sorts every 0-1 input of its size, and so sorts anything
+    for (int n : {3, 7, 12, 16})
+    {
+        auto network = oddEvenMergeNetwork(n);
+        for (int bits = 0; bits < (1 << n); ++bits)
+        {
+            int values[SmallHullMax];
+            for (int i = 0; i < n; ++i)
+                values[i] = bits >> i & 1;
+            for (int c = 0; c < network.size; ++c)
+                if (values[network.first[c]] > values[network.second[c]])
+                    swap(values[network.first[c]], values[network.second[c]]);
+            ASSERT_TRUE(is_sorted(values, values + n));
+        }
+    }
+}
@@ -1,47 +1,107 @@
 #include "Point.h"
 #include "Util.h"
+#include "SmallHull.h"
+#include "Workspace.h"
+#include "AllocationCounter.h"
 
 #include <vector>
 #include <stack>
+#include <memory_resource>
+#include <random>
+#include <thread>
 
 #include <gtest/gtest.h>
 
 
 using namespace std;
 
-// O(n * log(n))
-vector<Point> convexHullGrahamScan(vector<Point>& points)
+// O(n * log(n)). The chains are built in memory from resource, the hull is
+// written to output. The policy is the sort's: the chains are linear passes.
+template <typename T, typename Policy>
+void convexHullGrahamScan(const Policy& policy, vector<BasicPoint<T>>& points, vector<BasicPoint<T>>& output, pmr::memory_resource* resource)
 {
-    lexicographicSort(points);
+    TRACE_SPAN("convexHullGrahamScan");
 
-    vector<Point> upperConvexHull, lowerConvexHull;
-
-    for (int i = 0; i < points.size(); ++i)
+    if (points.size() <= SmallHullMax)
     {
-        if (!upperConvexHull.empty())
-            while (upperConvexHull.size() >= 2 && orientation(*(upperConvexHull.end() - 2), *(upperConvexHull.end() - 1), points[i]) == 1 || 
-                orientation(*(upperConvexHull.end() - 2), *(upperConvexHull.end() - 1), points[i]) == 0)
-                upperConvexHull.pop_back();
+        smallConvexHull(points, output);
+        return;
+    }
 
-        upperConvexHull.push_back(points[i]);
+    STATS_PHASE("sort");
+    lexicographicSort(policy, points);
 
-        if (!lowerConvexHull.empty())
-            while (lowerConvexHull.size() >= 2 && orientation(*(lowerConvexHull.end() - 2), *(lowerConvexHull.end() - 1), points[i]) == 2 || 
-                orientation(*(lowerConvexHull.end() - 2), *(lowerConvexHull.end() - 1), points[i]) == 0)
-                lowerConvexHull.pop_back();
+    STATS_NEXT_PHASE("lower chain");
+    pmr::vector<BasicPoint<T>> upperConvexHull(resource), lowerConvexHull(resource);
+
+    for (int i = 0; i < points.size(); ++i)
+    {
+        while (lowerConvexHull.size() >= 2 && (orientation(*(lowerConvexHull.end() - 2), *(lowerConvexHull.end() - 1), points[i]) == 1 ||
+            orientation(*(lowerConvexHull.end() - 2), *(lowerConvexHull.end() - 1), points[i]) == 0))
+            lowerConvexHull.pop_back();
 
         lowerConvexHull.push_back(points[i]);
     }
 
-    auto output = vector<Point>(upperConvexHull.begin(), upperConvexHull.end());
-    output.insert(output.end(), lowerConvexHull.rbegin(), lowerConvexHull.rend());
+    STATS_NEXT_PHASE("upper chain");
+    for (int i = 0; i < points.size(); ++i)
+    {
+        while (upperConvexHull.size() >= 2 && (orientation(*(upperConvexHull.end() - 2), *(upperConvexHull.end() - 1), points[i]) == 2 ||
+            orientation(*(upperConvexHull.end() - 2), *(upperConvexHull.end() - 1), points[i]) == 0))
+            upperConvexHull.pop_back();
 
-    sortPolygonInClockwiseOrder(output);
+        upperConvexHull.push_back(points[i]);
+    }
 
-    auto last = unique(output.begin(), output.end());
-    output.erase(last, output.end());
+    // clockwise from the leftmost point, each chain end once
+    STATS_NEXT_PHASE("output");
+    output.assign(upperConvexHull.begin(), upperConvexHull.end());
+    output.insert(output.end(), lowerConvexHull.rbegin() + 1, lowerConvexHull.rend() - 1);
 
+    // all points equal
+    output.erase(unique(output.begin(), output.end(), samePoint<T>), output.end());
+
+    rotateClockwiseRing(output.data(), output.size());
     output.push_back(output.front());
+}
+
+template <typename T>
+void convexHullGrahamScan(vector<BasicPoint<T>>& points, vector<BasicPoint<T>>& output, pmr::memory_resource* resource)
+{
+    convexHullGrahamScan(seq, points, output, resource);
+}
+
+template <typename T>
+vector<BasicPoint<T>> convexHullGrahamScan(vector<BasicPoint<T>>& points)
+{
+    vector<BasicPoint<T>> output;
+    convexHullGrahamScan(seq, points, output, pmr::get_default_resource());
+
+    return output;
+}
+
+// Without heap allocations once the workspace has seen an input of this size
+// and output has the capacity.
+template <typename T>
+void convexHullGrahamScan(vector<BasicPoint<T>>& points, vector<BasicPoint<T>>& output, Workspace& workspace)
+{
+    convexHullGrahamScan(seq, points, output, workspace.resource());
+}
+
+template <typename T>
+vector<BasicPoint<T>> convexHullGrahamScan(const SequencedPolicy& policy, vector<BasicPoint<T>>& points)
+{
+    vector<BasicPoint<T>> output;
+    convexHullGrahamScan(policy, points, output, pmr::get_default_resource());
+
+    return output;
+}
+
+template <typename T>
+vector<BasicPoint<T>> convexHullGrahamScan(const ParallelPolicy& policy, vector<BasicPoint<T>>& points)
+{
+    vector<BasicPoint<T>> output;
+    convexHullGrahamScan(policy, points, output, pmr::get_default_resource());
 
     return output;
 }
@@ -49,7 +109,7 @@ vector<Point> convexHullGrahamScan(vector<Point>& points)
 TEST(convexHullGrahamScan, simple)
 {
     vector<Point> input = { {1.1,1.2}, {-2,4}, {-3,12}, {4,-16}, {12,8}};
-    vector<Point> expected = { {-3, 12}, {12, 8}, {4, -16}, {-2, 4}, {-3, 12} };
+    vector<Point> expected = { {-2, 4}, {-3, 12}, {12, 8}, {4, -16}, {-2, 4} };
 
     auto output = convexHullGrahamScan(input);
 
@@ -126,3 +186,105 @@ TEST(convexHullGrahamScan, complex)
 
     EXPECT_TRUE(output == expected);
 }
+
+TEST(convexHullGrahamScan, workspace)
+{
+    mt19937 gen(79);
+    normal_distribution<double> coordinate(0., 1.);
+
+    vector<Point> points(20000);
+    for (auto& p : points)
+        p = {coordinate(gen), coordinate(gen)};
+
+    auto expected = convexHullGrahamScan(points);
+
+    Workspace workspace;
+    vector<Point> output;
+
+    for (int call = 0; call < 3; ++call)
+    {
+        long long before = heapAllocations;
+        convexHullGrahamScan(points, output, workspace);
+
+        if (call > 0)
+        {
+            EXPECT_EQ(heapAllocations, before);
+        }
+
+        EXPECT_TRUE(output == expected);
+    }
+
+    // small sets go to the fixed size kernels
+    vector<Point> few(points.begin(), points.begin() + 10);
+
+    long long before = heapAllocations;
+    convexHullGrahamScan(few, output, workspace);
+    EXPECT_EQ(heapAllocations, before);
+    EXPECT_TRUE(output == convexHullGrahamScan(few));
+}
+
+// Point's == has a tolerance.
+bool identical(const vector<Point>& a, const vector<Point>& b)
+{
+    return equal(a.begin(), a.end(), b.begin(), b.end(), samePoint<double>);
+}
+
+TEST(convexHullGrahamScan, policies)
+{
+    mt19937 gen(83);
+    normal_distribution<double> coordinate(0., 1.);
+    uniform_int_distribution<int> lattice(-100, 100);
+
+    // the lattice points repeat
+    vector<Point> points(100000);
+    for (int i = 0; i < points.size(); ++i)
+        points[i] = i % 2 ? Point{coordinate(gen), coordinate(gen)} : Point{double(lattice(gen)), double(lattice(gen))};
+
+    for (int nThreads : {1, 3, 4})
+    {
+        setThreadCount(nThreads);
+
+        auto sorted = points, parSorted = points, unseqSorted = points;
+        lexicographicSort(seq, sorted);
+        lexicographicSort(par, parSorted);
+        lexicographicSort(par_unseq, unseqSorted);
+
+        EXPECT_TRUE(identical(parSorted, sorted));
+        EXPECT_TRUE(identical(unseqSorted, sorted));
+
+        auto a = points, b = points, c = points;
+        auto expected = convexHullGrahamScan(seq, a);
+
+        EXPECT_TRUE(identical(convexHullGrahamScan(par, b), expected));
+        EXPECT_TRUE(identical(convexHullGrahamScan(par_unseq, c), expected));
+        EXPECT_TRUE(identical(b, a));
+    }
+
+    setThreadCount(thread::hardware_concurrency());
+}
+
+TEST(convexHullGrahamScan, smallSets)
+{
+    mt19937 gen(97);
+    uniform_int_distribution<int> coordinate(-4, 4);
+
+    // a small set repeated past SmallHullMax takes the generic path to the
+    // same ring; the lattice gives duplicates and collinear points
+    for (int n = 1; n <= SmallHullMax; ++n)
+    {
+        for (int trial = 0; trial < 100; ++trial)
+        {
+            vector<Point> points(n);
+            for (auto& p : points)
+                p = {coordinate(gen) / 4., trial % 3 ? coordinate(gen) / 4. : 0.};
+
+            vector<Point> repeated;
+            while (repeated.size() <= SmallHullMax)
+                repeated.insert(repeated.end(), points.begin(), points.end());
+
+            auto output = convexHullGrahamScan(points);
+            ASSERT_TRUE(isConvexRingOf(points.data(), points.data() + n, output));
+            ASSERT_TRUE(identical(output, convexHullGrahamScan(repeated)));
+        }
+    }
+}
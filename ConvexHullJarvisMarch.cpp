@@ -1,8 +1,11 @@
 #include "Point.h"
 #include "Util.h"
+#include "SmallHull.h"
 
 #include <vector>
 #include <algorithm>
+#include <random>
+#include <thread>
 
 #include <gtest/gtest.h>
 
@@ -28,15 +31,28 @@ algorithm jarvis(S) is
     until endpoint = P[0]      // wrapped around to first hull point
 */
 
-// O(n * h) time
-vector<Point> convexHullJarvisMarch(vector<Point>& points)
+// O(n * h) time. Needs no scratch memory: reusing output avoids all
+// allocations. The policy is the sort's: each step of the march keeps the
+// first of equally good candidates in input order, so it stays on one thread.
+template <typename T, typename Policy>
+void convexHullJarvisMarch(const Policy& policy, vector<BasicPoint<T>>& points, vector<BasicPoint<T>>& output)
 {
-    lexicographicSort(points);
+    TRACE_SPAN("convexHullJarvisMarch");
 
-    Point endPoint;
-    Point pointOnHull = points[0];
+    if (points.size() <= SmallHullMax)
+    {
+        smallConvexHull(points, output);
+        return;
+    }
+
+    STATS_PHASE("sort");
+    lexicographicSort(policy, points);
 
-    vector<Point> output;
+    STATS_NEXT_PHASE("march");
+    BasicPoint<T> endPoint;
+    BasicPoint<T> pointOnHull = points[0];
+
+    output.clear();
 
     int i = 0;
     do
@@ -51,8 +67,40 @@ vector<Point> convexHullJarvisMarch(vector<Point>& points)
         pointOnHull = endPoint;
     } while (endPoint != output[0]);
 
+    STATS_NEXT_PHASE("output");
     sortPolygonInClockwiseOrder(output);
     output.push_back(output.front());
+}
+
+template <typename T>
+void convexHullJarvisMarch(vector<BasicPoint<T>>& points, vector<BasicPoint<T>>& output)
+{
+    convexHullJarvisMarch(seq, points, output);
+}
+
+template <typename T>
+vector<BasicPoint<T>> convexHullJarvisMarch(vector<BasicPoint<T>>& points)
+{
+    vector<BasicPoint<T>> output;
+    convexHullJarvisMarch(seq, points, output);
+
+    return output;
+}
+
+template <typename T>
+vector<BasicPoint<T>> convexHullJarvisMarch(const SequencedPolicy& policy, vector<BasicPoint<T>>& points)
+{
+    vector<BasicPoint<T>> output;
+    convexHullJarvisMarch(policy, points, output);
+
+    return output;
+}
+
+template <typename T>
+vector<BasicPoint<T>> convexHullJarvisMarch(const ParallelPolicy& policy, vector<BasicPoint<T>>& points)
+{
+    vector<BasicPoint<T>> output;
+    convexHullJarvisMarch(policy, points, output);
 
     return output;
 }
@@ -138,3 +186,29 @@ TEST(convexHullJarvisMarch, complex)
 
     EXPECT_TRUE(output == expected);
 }
+
+TEST(convexHullJarvisMarch, policies)
+{
+    mt19937 gen(89);
+    normal_distribution<double> coordinate(0., 1000.);
+
+    vector<Point> points(50000);
+    for (auto& p : points)
+        p = {coordinate(gen), coordinate(gen)};
+
+    auto a = points;
+    auto expected = convexHullJarvisMarch(seq, a);
+
+    for (int nThreads : {1, 4})
+    {
+        setThreadCount(nThreads);
+
+        auto b = points, c = points;
+        auto output = convexHullJarvisMarch(par, b);
+
+        EXPECT_TRUE(equal(output.begin(), output.end(), expected.begin(), expected.end(), samePoint<double>));
+        EXPECT_EQ(convexHullJarvisMarch(par_unseq, c).size(), expected.size());
+    }
+
+    setThreadCount(thread::hardware_concurrency());
+}
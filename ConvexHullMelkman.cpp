@@ -0,0 +1,226 @@
+#include "Point.h"
+#include "Util.h"
+
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <random>
+
+#include <gtest/gtest.h>
+
+
+using namespace std;
+
+// Melkman's hull of a simple polyline, fed one vertex at a time in polyline
+// order: O(1) amortized per vertex and no sorting, so the hull of everything
+// pushed so far can be read at any time. Consecutive duplicates are skipped.
+// The input must not cross itself, the result is meaningless otherwise.
+//
+// The deque holds the hull counter-clockwise with the last vertex that was on
+// it at both ends. Until three vertices are not collinear only the two
+// extremes of the line so far are kept.
+template <typename T>
+class MelkmanHull
+{
+public:
+    void push(const BasicPoint<T>& p)
+    {
+        if (m_count > 0 && samePoint(p, m_last))
+            return;
+
+        ++m_count;
+        m_last = p;
+
+        if (m_deque.empty())
+        {
+            pushOnLine(p);
+            return;
+        }
+
+        int top = m_deque.size() - 1;
+        // inside or on the hull
+        if (orientation(m_deque[0], m_deque[1], p) != CW && orientation(m_deque[top - 1], m_deque[top], p) != CW)
+            return;
+
+        while (m_deque.size() > 2 && orientation(m_deque[0], m_deque[1], p) != CCW)
+            m_deque.pop_front();
+        m_deque.push_front(p);
+
+        while (m_deque.size() > 2 && orientation(m_deque[m_deque.size() - 2], m_deque.back(), p) != CCW)
+            m_deque.pop_back();
+        m_deque.push_back(p);
+    }
+
+    // Hull so far as a clockwise closed ring; {p, p} for one point, {a, b, a}
+    // for a line. Unlike the other hull functions it starts at the last vertex
+    // on it; rotateClockwiseRing on the ring without its repeated front gives
+    // their start.
+    vector<BasicPoint<T>> hull() const
+    {
+        if (!m_deque.empty())
+            return vector<BasicPoint<T>>(m_deque.rbegin(), m_deque.rend());
+
+        if (m_line.empty())
+            return {};
+
+        if (m_line.size() == 1)
+            return {m_line.front(), m_line.front()};
+
+        return {m_line.front(), m_line.back(), m_line.front()};
+    }
+
+    // Number of vertices pushed, without the skipped duplicates.
+    int count() const
+    {
+        return m_count;
+    }
+
+    void clear()
+    {
+        m_deque.clear();
+        m_line.clear();
+        m_count = 0;
+    }
+
+private:
+    void pushOnLine(const BasicPoint<T>& p)
+    {
+        if (m_line.size() < 2)
+        {
+            m_line.push_back(p);
+            return;
+        }
+
+        auto o = orientation(m_line[0], m_line[1], p);
+        if (o == COLINEAR)
+        {
+            BasicPoint<T> points[] = {m_line[0], m_line[1], p};
+            auto extremes = minmax_element(points, points + 3, lexicographicLess<T>);
+            m_line = {*extremes.first, *extremes.second};
+            return;
+        }
+
+        if (o == CCW)
+            m_deque = {p, m_line[0], m_line[1], p};
+        else
+            m_deque = {p, m_line[1], m_line[0], p};
+
+        m_line.clear();
+    }
+
+private:
+    deque<BasicPoint<T>> m_deque;
+    vector<BasicPoint<T>> m_line;
+
+    BasicPoint<T> m_last;
+    int m_count = 0;
+};
+
+// O(n) hull of a simple polyline or polygon given in vertex order.
+template <typename T>
+vector<BasicPoint<T>> convexHullMelkman(const vector<BasicPoint<T>>& polyline)
+{
+    TRACE_SPAN("convexHullMelkman");
+
+    MelkmanHull<T> hull;
+    for (const auto& p : polyline)
+        hull.push(p);
+
+    return hull.hull();
+}
+
+
+// Checks the hull after every vertex against the hull of the prefix.
+template <typename T>
+void checkPrefixes(const vector<BasicPoint<T>>& polyline)
+{
+    MelkmanHull<T> melkman;
+    vector<BasicPoint<T>> prefix;
+
+    for (const auto& p : polyline)
+    {
+        melkman.push(p);
+        prefix.push_back(p);
+
+        ASSERT_TRUE(isConvexRingOf(prefix.data(), prefix.data() + prefix.size(), melkman.hull()));
+    }
+}
+
+TEST(convexHullMelkman, simple)
+{
+    // concave octagon
+    vector<Point> polygon = { {0, 0}, {2, 1}, {4, 0}, {3, 2}, {4, 4}, {2, 3}, {0, 4}, {1, 2} };
+
+    auto hull = convexHullMelkman(polygon);
+
+    vector<Point> expected = { {0, 4}, {4, 4}, {4, 0}, {0, 0}, {0, 4} };
+    EXPECT_TRUE(equal(hull.begin(), hull.end(), expected.begin(), expected.end(), samePoint<double>));
+
+    checkPrefixes(polygon);
+
+    // the last vertex is on an edge of the hull so far
+    vector<Point> onEdge = { {0, 0}, {4, 0}, {4, 4}, {2, 2} };
+    hull = convexHullMelkman(onEdge);
+
+    expected = { {4, 4}, {4, 0}, {0, 0}, {4, 4} };
+    EXPECT_TRUE(equal(hull.begin(), hull.end(), expected.begin(), expected.end(), samePoint<double>));
+
+    checkPrefixes(onEdge);
+
+    // a collinear start with duplicates, then a turn
+    vector<Point> polyline = { {0, 0}, {0, 0}, {1, 1}, {2, 2}, {2, 2}, {3, 3}, {3, 1}, {2, 0} };
+    checkPrefixes(polyline);
+
+    MelkmanHull<double> melkman;
+    EXPECT_TRUE(melkman.hull().empty());
+    melkman.push(polyline[0]);
+    EXPECT_EQ(melkman.hull().size(), 2);
+    for (int i = 0; i < 4; ++i)
+        melkman.push(polyline[i]);
+    EXPECT_EQ(melkman.count(), 3);
+    EXPECT_EQ(melkman.hull().size(), 3);
+}
+
+TEST(convexHullMelkman, random)
+{
+    mt19937 gen(59);
+    uniform_real_distribution<double> coordinate(-10., 10.), step(0.01, 1.);
+
+    for (int trial = 0; trial < 20; ++trial)
+    {
+        // an x-monotone track and a star-shaped polygon are simple
+        vector<Point> track;
+        double x = 0.;
+        for (int i = 0; i < 200; ++i)
+        {
+            x += step(gen);
+            track.push_back({x, coordinate(gen)});
+        }
+        checkPrefixes(track);
+
+        vector<Point> star(200);
+        for (auto& p : star)
+            p = {coordinate(gen), coordinate(gen)};
+        sort(star.begin(), star.end(), [](const Point& p1, const Point& p2) {
+            return atan2(p1.y, p1.x) < atan2(p2.y, p2.x);
+        });
+        checkPrefixes(star);
+    }
+}
+
+TEST(convexHullMelkman, integer)
+{
+    mt19937 gen(61);
+    uniform_int_distribution<int> dy(-2, 2), dx(0, 1);
+
+    // a monotone lattice walk with repeated points and collinear runs
+    vector<BasicPoint<int32_t>> track = {{0, 0}};
+    for (int i = 0; i < 500; ++i)
+    {
+        int x = track.back().x + dx(gen);
+        int y = x == track.back().x ? track.back().y + abs(dy(gen)) : track.back().y + dy(gen);
+        track.push_back({x, y});
+    }
+
+    checkPrefixes(track);
+}
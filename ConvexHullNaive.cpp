@@ -1,11 +1,13 @@
 #include "Point.h"
 #include "Util.h"
+#include "SmallHull.h"
 
 #include <algorithm>
 #include <iostream>
 #include <vector>
 #include <cmath>
 #include <numeric>
+#include <random>
 
 #include <gtest/gtest.h>
 
@@ -13,10 +15,22 @@
 using namespace std;
 
 
-// Takes O(n^3) time
-vector<Point> convexHullNaive(const vector<Point>& points)
+// Takes O(n^3) time. Needs no scratch memory: reusing output avoids all
+// allocations.
+template <typename T>
+void convexHullNaive(const vector<BasicPoint<T>>& points, vector<BasicPoint<T>>& output)
 {
-    vector<Point> output;
+    TRACE_SPAN("convexHullNaive");
+
+    if (points.size() <= SmallHullMax)
+    {
+        smallConvexHull(points, output);
+        return;
+    }
+
+    STATS_PHASE("march");
+
+    output.clear();
     auto n = points.size();
 
     int leftmost = 0;
@@ -43,13 +57,35 @@ vector<Point> convexHullNaive(const vector<Point>& points)
         p = q;
     } while (p != leftmost);
 
+    STATS_NEXT_PHASE("output");
     sortPolygonInClockwiseOrder(output);
 
     output.push_back(output.front());
+}
+
+template <typename T>
+vector<BasicPoint<T>> convexHullNaive(const vector<BasicPoint<T>>& points)
+{
+    vector<BasicPoint<T>> output;
+    convexHullNaive(points, output);
 
     return output;
 }
 
+// For a policy at the call site; the march runs on the calling thread either
+// way, see convexHullJarvisMarch.
+template <typename T>
+vector<BasicPoint<T>> convexHullNaive(const SequencedPolicy&, const vector<BasicPoint<T>>& points)
+{
+    return convexHullNaive(points);
+}
+
+template <typename T>
+vector<BasicPoint<T>> convexHullNaive(const ParallelPolicy&, const vector<BasicPoint<T>>& points)
+{
+    return convexHullNaive(points);
+}
+
 TEST(convexHullNaive, simple)
 {
     vector<Point> input = { {1.1,1.2}, {-2,4}, {-3,12}, {4,-16}, {12,8}};
@@ -131,3 +167,45 @@ TEST(convexHullNaive, complex)
 
     EXPECT_TRUE(output == expected);
 }
+
+TEST(convexHullNaive, scalarTypes)
+{
+    vector<BasicPoint<int32_t>> input = { {1, 1}, {-2, 4}, {-3, 12}, {4, -16}, {12, 8} };
+    vector<BasicPoint<int32_t>> expected = { {-2, 4}, {-3, 12}, {12, 8}, {4, -16}, {-2, 4} };
+
+    EXPECT_TRUE(convexHullNaive(input) == expected);
+
+    vector<BasicPoint<float>> inputf = { {1.1f, 1.2f}, {-2, 4}, {-3, 12}, {4, -16}, {12, 8} };
+    vector<BasicPoint<float>> expectedf = { {-2, 4}, {-3, 12}, {12, 8}, {4, -16}, {-2, 4} };
+
+    EXPECT_TRUE(convexHullNaive(inputf) == expectedf);
+
+    // the cross products need more than 64 bits, the orientation is off by 2
+    int64_t a = (int64_t(1) << 40) + 1, b = (int64_t(1) << 40) - 1;
+    BasicPoint<int64_t> p{0, 0}, q{a, b};
+
+    EXPECT_EQ(orientation(p, q, {2 * a, 2 * b}), COLINEAR);
+    EXPECT_EQ(orientation(p, q, {2 * a + 1, 2 * b + 1}), CCW);
+    EXPECT_EQ(orientation(p, q, {2 * a - 1, 2 * b - 1}), CW);
+
+    BasicPoint<int32_t> lo{INT32_MIN, INT32_MIN}, hi{INT32_MAX, INT32_MAX};
+    EXPECT_EQ(orientation(lo, hi, {INT32_MAX, INT32_MIN}), CW);
+    EXPECT_EQ(orientation(lo, hi, {-1, 0}), CCW);
+    EXPECT_EQ(orientation(lo, hi, {0, 0}), COLINEAR);
+}
+
+TEST(convexHullNaive, policies)
+{
+    mt19937 gen(97);
+    uniform_real_distribution<double> coordinate(-1000., 1000.);
+
+    vector<Point> points(2000);
+    for (auto& p : points)
+        p = {coordinate(gen), coordinate(gen)};
+
+    auto expected = convexHullNaive(points);
+
+    EXPECT_TRUE(convexHullNaive(seq, points) == expected);
+    EXPECT_TRUE(convexHullNaive(par, points) == expected);
+    EXPECT_TRUE(convexHullNaive(par_unseq, points) == expected);
+}
@@ -1,12 +1,58 @@
 #pragma once
 
-#include <functional>
+#include "../Stats.h"
 
-template <typename T>
+#include <cstddef>
+#include <iterator>
+#include <vector>
+
+// Augmentations maintain a per-subtree aggregate in every node. update() is
+// called bottom-up whenever the children of a node change and must recompute
+// node->augmentation from node->key and the children's aggregates.
+template <typename V>
+struct AugmentationData
+{
+    V augmentation;
+};
+
+template <>
+struct AugmentationData<void>
+{
+};
+
+struct NoAugmentation
+{
+    using value_type = void;
+
+    template <typename Node>
+    static void update(Node*)
+    {
+    }
+};
+
+// Enables rank(), select(), count() and size().
+struct SubtreeSize
+{
+    using value_type = int;
+
+    template <typename Node>
+    static void update(Node* node)
+    {
+        node->augmentation = 1 + size(node->leftChild) + size(node->rightChild);
+    }
+
+    template <typename Node>
+    static int size(const Node* node)
+    {
+        return node ? node->augmentation : 0;
+    }
+};
+
+template <typename T, typename Augmentation = NoAugmentation>
 class AVLTree
 {
 public:
-    struct AVLNode
+    struct AVLNode : AugmentationData<typename Augmentation::value_type>
     {
         int balanceFactor;
 
@@ -29,6 +75,77 @@ public:
         }
     };
 
+    // AVL height is below 1.45 * log2(n + 2), so 64 levels cover any tree that
+    // fits in memory. Used to size the explicit stacks of the iterative code.
+    static constexpr int MaxHeight = 64;
+
+    class const_iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+
+        const_iterator() = default;
+
+        reference operator* () const
+        {
+            return m_stack[m_depth - 1]->key;
+        }
+
+        pointer operator-> () const
+        {
+            return &m_stack[m_depth - 1]->key;
+        }
+
+        const_iterator& operator++ ()
+        {
+            pushLeftSpine(m_stack[--m_depth]->rightChild);
+            return *this;
+        }
+
+        const_iterator operator++ (int)
+        {
+            auto it = *this;
+            ++*this;
+            return it;
+        }
+
+        bool operator== (const const_iterator& other) const
+        {
+            return current() == other.current();
+        }
+
+        bool operator!= (const const_iterator& other) const
+        {
+            return !(*this == other);
+        }
+
+    private:
+        friend class AVLTree;
+
+        explicit const_iterator(AVLNode* root)
+        {
+            pushLeftSpine(root);
+        }
+
+        void pushLeftSpine(AVLNode* node)
+        {
+            for (; node; node = node->leftChild)
+                m_stack[m_depth++] = node;
+        }
+
+        AVLNode* current() const
+        {
+            return m_depth ? m_stack[m_depth - 1] : nullptr;
+        }
+
+        AVLNode* m_stack[MaxHeight];
+        int m_depth = 0;
+    };
+
 public:
     AVLTree();
 
@@ -41,7 +158,11 @@ public:
 
     bool find(const T& val) const;
 
-    void inorder(std::function<void (T)> traverser) const;
+    template <typename Visitor>
+    void inorder(Visitor&& visitor) const;
+
+    const_iterator begin() const;
+    const_iterator end() const;
     
     void insert(const T& key);
 
@@ -49,11 +170,45 @@ public:
 
     int height() const;
 
-    AVLNode* removeMin();
+    // Moves the smallest key to out; false if the tree is empty.
+    bool removeMin(T& out);
 
     AVLNode* predecessor(const T& val) const;
 
     AVLNode* successor(const T& val) const;
+
+    // Replaces the contents with the strictly increasing range [first, last) in O(n).
+    template <typename RandomIt>
+    void build(RandomIt first, RandomIt last);
+
+    // Replaces the contents with left + key + right in O(|h(left) - h(right)|).
+    // Every key of left must be smaller than key and every key of right larger.
+    // left and right are emptied.
+    void join(AVLTree& left, const T& key, AVLTree& right);
+
+    // Moves the keys smaller than key into left and the larger ones into right
+    // in O(log n), leaving this tree empty. Returns whether key was present.
+    bool split(const T& key, AVLTree& left, AVLTree& right);
+
+    // Batch updates with a strictly increasing range, done by merging with the
+    // inorder sequence and rebuilding: O(n + m) instead of O(m * log(n + m)).
+    template <typename InputIt>
+    void insertSorted(InputIt first, InputIt last);
+
+    template <typename InputIt>
+    void removeSorted(InputIt first, InputIt last);
+
+    // Order statistics, O(log n). Require an augmentation providing size().
+    int size() const;
+
+    // Number of keys smaller than val.
+    int rank(const T& val) const;
+
+    // k-th smallest key (0-based), nullptr if k is out of range.
+    AVLNode* select(int k) const;
+
+    // Number of keys in [lo, hi].
+    int count(const T& lo, const T& hi) const;
      
 private:
     void update(AVLNode* node);
@@ -62,22 +217,20 @@ private:
 
     void destroy(AVLNode* node);
  
-    bool _find(const T& val, AVLNode* node) const;
-    
-    AVLNode* _insert(const T& val, AVLNode* node);
+    // Re-establishes heights, aggregates and balance bottom-up along a root path.
+    void rebalancePath(AVLNode** path[], int depth);
 
     AVLNode* _findMin(AVLNode* node) const;
     AVLNode* _findMax(AVLNode* node) const;
-    
-    AVLNode* _remove(const T& val, AVLNode* node);
-    
-    void _inorder(AVLNode* node, std::function<void (T)> traverser) const;
 
-    int _height(AVLNode* node) const;
+    template <typename RandomIt>
+    AVLNode* _build(RandomIt first, RandomIt last);
 
-    void _predecessor(const T& val, AVLNode* node, AVLNode** predecessorNode) const;
+    AVLNode* _join(AVLNode* left, AVLNode* node, AVLNode* right);
 
-    void _successor(const T& val, AVLNode* node, AVLNode** successorNode) const;
+    void _split(const T& val, AVLNode* node, AVLNode** left, AVLNode** right, bool* found);
+
+    static int nodeHeight(AVLNode* node);
 
 private:
     AVLNode* leftLeftCase(AVLNode* node);
@@ -91,99 +244,384 @@ private:
 
 private:
     AVLNode* m_root;
-    int m_nNodes = 0;
 };
 
-template <typename T>
-AVLTree<T>::AVLTree() :
+template <typename T, typename Augmentation>
+AVLTree<T, Augmentation>::AVLTree() :
     m_root(nullptr)
 {
 }
 
-template <typename T>
-AVLTree<T>::~AVLTree()
+template <typename T, typename Augmentation>
+AVLTree<T, Augmentation>::~AVLTree()
 {
     destroy(m_root);
 }
 
-template <typename T>
-inline bool AVLTree<T>::isEmpty() const
+template <typename T, typename Augmentation>
+inline bool AVLTree<T, Augmentation>::isEmpty() const
 {
     return !m_root;
 }
 
-template <typename T>
-inline typename AVLTree<T>::AVLNode* AVLTree<T>::min() const
+template <typename T, typename Augmentation>
+inline typename AVLTree<T, Augmentation>::AVLNode* AVLTree<T, Augmentation>::min() const
 {
     return _findMin(m_root);
 }
 
-template <typename T>
-inline typename AVLTree<T>::AVLNode *AVLTree<T>::max() const
+template <typename T, typename Augmentation>
+inline typename AVLTree<T, Augmentation>::AVLNode *AVLTree<T, Augmentation>::max() const
 {
     return _findMax(m_root);
 }
 
-template <typename T>
-bool AVLTree<T>::find(const T &val) const
+template <typename T, typename Augmentation>
+bool AVLTree<T, Augmentation>::find(const T &val) const
+{
+    AVLNode* node = m_root;
+
+    while (node)
+    {
+        if (val < node->key)
+            node = node->leftChild;
+        else if (val > node->key)
+            node = node->rightChild;
+        else
+            return true;
+    }
+
+    return false;
+}
+
+template <typename T, typename Augmentation>
+template <typename Visitor>
+void AVLTree<T, Augmentation>::inorder(Visitor&& visitor) const
 {
-    return _find(val, m_root);
+    for (const auto& key : *this)
+        visitor(key);
 }
 
-template <typename T>
-void AVLTree<T>::inorder(std::function<void(T)> traverser) const
+template <typename T, typename Augmentation>
+inline typename AVLTree<T, Augmentation>::const_iterator AVLTree<T, Augmentation>::begin() const
 {
-    _inorder(m_root, traverser);
+    return const_iterator(m_root);
 }
 
-template <typename T>
-void AVLTree<T>::insert(const T &key)
+template <typename T, typename Augmentation>
+inline typename AVLTree<T, Augmentation>::const_iterator AVLTree<T, Augmentation>::end() const
 {
-    m_root = _insert(key, m_root);
-    ++m_nNodes;
+    return const_iterator();
 }
 
-template <typename T>
-void AVLTree<T>::remove(const T &key)
+template <typename T, typename Augmentation>
+void AVLTree<T, Augmentation>::insert(const T &key)
 {
-    m_root = _remove(key, m_root);
+    AVLNode** path[MaxHeight];
+    int depth = 0;
+
+    AVLNode** link = &m_root;
+    while (*link)
+    {
+        path[depth++] = link;
+
+        if (key < (*link)->key)
+            link = &(*link)->leftChild;
+        else if (key > (*link)->key)
+            link = &(*link)->rightChild;
+        else
+            return;
+    }
+
+    *link = new AVLNode(key);
+    update(*link);
+    STATS_COUNT(treeAllocations);
+
+    rebalancePath(path, depth);
+    STATS_MAX(treeMaxHeight, height());
 }
 
-template <typename T>
-inline int AVLTree<T>::height() const
+template <typename T, typename Augmentation>
+void AVLTree<T, Augmentation>::remove(const T &key)
 {
-    return _height(m_root);
+    AVLNode** path[MaxHeight];
+    int depth = 0;
+
+    AVLNode** link = &m_root;
+    while (*link)
+    {
+        if (key < (*link)->key)
+        {
+            path[depth++] = link;
+            link = &(*link)->leftChild;
+        }
+        else if (key > (*link)->key)
+        {
+            path[depth++] = link;
+            link = &(*link)->rightChild;
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    if (!*link)
+        return;
+
+    AVLNode* node = *link;
+    if (node->leftChild && node->rightChild)
+    {
+        // Replace the key by its neighbour from the taller side and unlink that one instead.
+        path[depth++] = link;
+
+        if (node->leftChild->height > node->rightChild->height)
+        {
+            link = &node->leftChild;
+            while ((*link)->rightChild)
+            {
+                path[depth++] = link;
+                link = &(*link)->rightChild;
+            }
+        }
+        else
+        {
+            link = &node->rightChild;
+            while ((*link)->leftChild)
+            {
+                path[depth++] = link;
+                link = &(*link)->leftChild;
+            }
+        }
+
+        node->key = (*link)->key;
+    }
+
+    AVLNode* removed = *link;
+    *link = removed->leftChild ? removed->leftChild : removed->rightChild;
+    delete removed;
+
+    rebalancePath(path, depth);
+}
+
+template <typename T, typename Augmentation>
+inline int AVLTree<T, Augmentation>::height() const
+{
+    return nodeHeight(m_root);
 }
 
-template <typename T>
-typename AVLTree<T>::AVLNode* AVLTree<T>::removeMin()
+template <typename T, typename Augmentation>
+bool AVLTree<T, Augmentation>::removeMin(T& out)
 {
     auto* minNode = _findMin(m_root);
+    if (!minNode)
+        return false;
 
-    if (minNode)
-        remove(minNode->key);
-    
-    return minNode;
+    out = minNode->key;
+    remove(out);
+
+    return true;
 }
 
-template <typename T>
-inline typename AVLTree<T>::AVLNode* AVLTree<T>::predecessor(const T &val) const
+template <typename T, typename Augmentation>
+typename AVLTree<T, Augmentation>::AVLNode* AVLTree<T, Augmentation>::predecessor(const T &val) const
 {
     AVLNode* predecessorNode = nullptr;
-    _predecessor(val, m_root, &predecessorNode);
+    AVLNode* node = m_root;
+
+    while (node)
+    {
+        if (node->key == val)
+        {
+            if (node->leftChild)
+                predecessorNode = _findMax(node->leftChild);
+            break;
+        }
+        else if (node->key > val)
+        {
+            node = node->leftChild;
+        }
+        else
+        {
+            predecessorNode = node;
+            node = node->rightChild;
+        }
+    }
+
     return predecessorNode;
 }
 
-template <typename T>
-inline typename AVLTree<T>::AVLNode* AVLTree<T>::successor(const T &val) const
+template <typename T, typename Augmentation>
+typename AVLTree<T, Augmentation>::AVLNode* AVLTree<T, Augmentation>::successor(const T &val) const
 {
     AVLNode* successorNode = nullptr;
-    _successor(val, m_root, &successorNode);
+    AVLNode* node = m_root;
+
+    while (node)
+    {
+        if (node->key == val)
+        {
+            if (node->rightChild)
+                successorNode = _findMin(node->rightChild);
+            break;
+        }
+        else if (node->key > val)
+        {
+            successorNode = node;
+            node = node->leftChild;
+        }
+        else
+        {
+            node = node->rightChild;
+        }
+    }
+
     return successorNode;
 }
 
-template <typename T>
-void AVLTree<T>::update(AVLNode* node)
+template <typename T, typename Augmentation>
+template <typename RandomIt>
+void AVLTree<T, Augmentation>::build(RandomIt first, RandomIt last)
+{
+    destroy(m_root);
+    m_root = _build(first, last);
+}
+
+template <typename T, typename Augmentation>
+void AVLTree<T, Augmentation>::join(AVLTree& left, const T& key, AVLTree& right)
+{
+    AVLNode* leftRoot = left.m_root;
+    AVLNode* rightRoot = right.m_root;
+
+    left.m_root = nullptr;
+    right.m_root = nullptr;
+
+    destroy(m_root);
+    m_root = _join(leftRoot, new AVLNode(key), rightRoot);
+    STATS_COUNT(treeAllocations);
+}
+
+template <typename T, typename Augmentation>
+bool AVLTree<T, Augmentation>::split(const T& key, AVLTree& left, AVLTree& right)
+{
+    AVLNode* root = m_root;
+    m_root = nullptr;
+
+    destroy(left.m_root);
+    destroy(right.m_root);
+
+    bool found = false;
+    _split(key, root, &left.m_root, &right.m_root, &found);
+
+    return found;
+}
+
+template <typename T, typename Augmentation>
+template <typename InputIt>
+void AVLTree<T, Augmentation>::insertSorted(InputIt first, InputIt last)
+{
+    std::vector<T> keys(begin(), end());
+
+    std::vector<T> merged;
+
+    auto it = keys.begin();
+    for (; first != last; ++first)
+    {
+        while (it != keys.end() && *it < *first)
+            merged.push_back(*it++);
+
+        if (it != keys.end() && !(*first < *it))
+            merged.push_back(*it++);
+        else
+            merged.push_back(*first);
+    }
+    merged.insert(merged.end(), it, keys.end());
+
+    build(merged.begin(), merged.end());
+}
+
+template <typename T, typename Augmentation>
+template <typename InputIt>
+void AVLTree<T, Augmentation>::removeSorted(InputIt first, InputIt last)
+{
+    std::vector<T> kept;
+    inorder([&](const T& key) {
+        while (first != last && *first < key)
+            ++first;
+
+        if (first == last || key < *first)
+            kept.push_back(key);
+    });
+
+    build(kept.begin(), kept.end());
+}
+
+template <typename T, typename Augmentation>
+inline int AVLTree<T, Augmentation>::size() const
+{
+    return Augmentation::size(m_root);
+}
+
+template <typename T, typename Augmentation>
+int AVLTree<T, Augmentation>::rank(const T& val) const
+{
+    int result = 0;
+    AVLNode* node = m_root;
+
+    while (node)
+    {
+        if (val > node->key)
+        {
+            result += Augmentation::size(node->leftChild) + 1;
+            node = node->rightChild;
+        }
+        else
+        {
+            node = node->leftChild;
+        }
+    }
+
+    return result;
+}
+
+template <typename T, typename Augmentation>
+typename AVLTree<T, Augmentation>::AVLNode* AVLTree<T, Augmentation>::select(int k) const
+{
+    AVLNode* node = m_root;
+
+    while (node)
+    {
+        int leftSize = Augmentation::size(node->leftChild);
+
+        if (k < leftSize)
+        {
+            node = node->leftChild;
+        }
+        else if (k > leftSize)
+        {
+            k -= leftSize + 1;
+            node = node->rightChild;
+        }
+        else
+        {
+            return node;
+        }
+    }
+
+    return nullptr;
+}
+
+template <typename T, typename Augmentation>
+int AVLTree<T, Augmentation>::count(const T& lo, const T& hi) const
+{
+    if (hi < lo)
+        return 0;
+
+    return rank(hi) - rank(lo) + (find(hi) ? 1 : 0);
+}
+
+template <typename T, typename Augmentation>
+void AVLTree<T, Augmentation>::update(AVLNode* node)
 {
     if (!node)
         return;
@@ -194,10 +632,12 @@ void AVLTree<T>::update(AVLNode* node)
     node->height =  1 + std::max(leftNodeHeight, rightNodeHeight);
 
     node->balanceFactor = rightNodeHeight - leftNodeHeight;
+
+    Augmentation::update(node);
 }
 
-template <typename T>
-typename AVLTree<T>::AVLNode* AVLTree<T>::balance(AVLNode *node)
+template <typename T, typename Augmentation>
+typename AVLTree<T, Augmentation>::AVLNode* AVLTree<T, Augmentation>::balance(AVLNode *node)
 {
     if (node->balanceFactor == -2)
     {
@@ -217,8 +657,19 @@ typename AVLTree<T>::AVLNode* AVLTree<T>::balance(AVLNode *node)
     return node;
 }
 
-template <typename T>
-void AVLTree<T>::destroy(AVLNode *node)
+template <typename T, typename Augmentation>
+void AVLTree<T, Augmentation>::rebalancePath(AVLNode** path[], int depth)
+{
+    while (depth > 0)
+    {
+        AVLNode** link = path[--depth];
+        update(*link);
+        *link = balance(*link);
+    }
+}
+
+template <typename T, typename Augmentation>
+void AVLTree<T, Augmentation>::destroy(AVLNode *node)
 {
     if (!node)
         return;
@@ -228,38 +679,8 @@ void AVLTree<T>::destroy(AVLNode *node)
     delete node;
 }
 
-template <typename T>
-bool AVLTree<T>::_find(const T &val, AVLNode *node) const
-{
-    if (!node)
-        return false;
-
-    if (val < node->key)
-        return _find(val, node->leftChild);
-    else if (val > node->key)
-        return _find(val, node->rightChild);
-    else
-        return true;
-}
-
-template <typename T>
-typename AVLTree<T>::AVLNode* AVLTree<T>::_insert(const T &val, AVLNode *node)
-{
-    if (!node)
-        return new AVLNode(val);
-
-    if (val < node->key)
-        node->leftChild = _insert(val, node->leftChild);
-    else if (val > node->key)
-        node->rightChild =_insert(val, node->rightChild);
-
-    update(node);
-
-    return balance(node);
-}
-
-template <typename T>
-typename AVLTree<T>::AVLNode *AVLTree<T>::_findMin(AVLNode *node) const
+template <typename T, typename Augmentation>
+typename AVLTree<T, Augmentation>::AVLNode *AVLTree<T, Augmentation>::_findMin(AVLNode *node) const
 {
     while (node && node->leftChild)
         node = node->leftChild;
@@ -267,8 +688,8 @@ typename AVLTree<T>::AVLNode *AVLTree<T>::_findMin(AVLNode *node) const
     return node;
 }
 
-template<typename T>
-typename AVLTree<T>::AVLNode* AVLTree<T>::_findMax(AVLNode *node) const
+template <typename T, typename Augmentation>
+typename AVLTree<T, Augmentation>::AVLNode* AVLTree<T, Augmentation>::_findMax(AVLNode *node) const
 {
     while (node && node->rightChild)
         node = node->rightChild;
@@ -276,153 +697,122 @@ typename AVLTree<T>::AVLNode* AVLTree<T>::_findMax(AVLNode *node) const
     return node;
 }
 
-template <typename T>
-typename AVLTree<T>::AVLNode* AVLTree<T>::_remove(const T &val, AVLNode *node)
+template <typename T, typename Augmentation>
+template <typename RandomIt>
+typename AVLTree<T, Augmentation>::AVLNode* AVLTree<T, Augmentation>::_build(RandomIt first, RandomIt last)
 {
-    if (!node)
+    if (first == last)
         return nullptr;
 
-    if (val < node->key)
-        node->leftChild = _remove(val, node->leftChild);
-    else if (val > node->key)
-        node->rightChild = _remove(val, node->rightChild);
-    else
-    {
-        if (!node->leftChild)
-        {
-            return node->rightChild;
-        }
-        else if (!node->rightChild)
-        {
-            return node->leftChild;
-        }
-        else
-        {
-            if (node->leftChild->height > node->rightChild->height)
-            {
-                AVLNode *temp = _findMax(node->leftChild);
-                node->key = temp->key;
-                node->leftChild = _remove(temp->key, node->leftChild);
-            }
-            else
-            {
-                AVLNode* temp = _findMin(node->rightChild);
-                node->key = temp->key;
-                node->rightChild = _remove(temp->key, node->rightChild);
-            }
-        }
-    }
+    auto mid = first + (last - first) / 2;
+
+    auto* node = new AVLNode(*mid);
+    STATS_COUNT(treeAllocations);
+    node->leftChild = _build(first, mid);
+    node->rightChild = _build(mid + 1, last);
 
     update(node);
 
-    return balance(node);
+    return node;
 }
 
-template <typename T>
-void AVLTree<T>::_inorder(AVLNode *node, std::function<void(T)> traverser) const
+template <typename T, typename Augmentation>
+typename AVLTree<T, Augmentation>::AVLNode* AVLTree<T, Augmentation>::_join(AVLNode* left, AVLNode* node, AVLNode* right)
 {
-    if (!node)
-        return;
+    int leftHeight = nodeHeight(left);
+    int rightHeight = nodeHeight(right);
 
-    _inorder(node->leftChild, traverser);
-    traverser(node->key);
-    _inorder(node->rightChild, traverser);
-}
+    if (leftHeight > rightHeight + 1)
+    {
+        left->rightChild = _join(left->rightChild, node, right);
+        update(left);
+        return balance(left);
+    }
+    else if (rightHeight > leftHeight + 1)
+    {
+        right->leftChild = _join(left, node, right->leftChild);
+        update(right);
+        return balance(right);
+    }
 
-template <typename T>
-int AVLTree<T>::_height(AVLNode *node) const
-{
-    if (!node)
-        return -1;
+    node->leftChild = left;
+    node->rightChild = right;
+    update(node);
 
-    return 1 + std::max(_height(node->leftChild), _height(node->rightChild));
+    return node;
 }
 
-template <typename T>
-void AVLTree<T>::_predecessor(const T &val, AVLNode *node, AVLNode** predecessorNode) const
+template <typename T, typename Augmentation>
+void AVLTree<T, Augmentation>::_split(const T& val, AVLNode* node, AVLNode** left, AVLNode** right, bool* found)
 {
     if (!node)
+    {
+        *left = nullptr;
+        *right = nullptr;
         return;
+    }
 
-    if (node->key == val)
-    {
-        if (node->leftChild)
-        {
-            AVLNode* n = node->leftChild;
-            while (n->rightChild)
-                n = n->rightChild;
+    AVLNode* leftChild = node->leftChild;
+    AVLNode* rightChild = node->rightChild;
 
-            *predecessorNode = n;
-        }
+    if (val < node->key)
+    {
+        AVLNode* splitRight = nullptr;
+        _split(val, leftChild, left, &splitRight, found);
+        *right = _join(splitRight, node, rightChild);
     }
-    else if (node->key > val)
+    else if (val > node->key)
     {
-        _predecessor(val, node->leftChild, predecessorNode);
+        AVLNode* splitLeft = nullptr;
+        _split(val, rightChild, &splitLeft, right, found);
+        *left = _join(leftChild, node, splitLeft);
     }
     else
     {
-        *predecessorNode = node;
-        _predecessor(val, node->rightChild, predecessorNode);
+        *left = leftChild;
+        *right = rightChild;
+        *found = true;
+        delete node;
     }
 }
 
-template <typename T>
-void AVLTree<T>::_successor(const T &val, AVLNode *node, AVLNode** successorNode) const
+template <typename T, typename Augmentation>
+inline int AVLTree<T, Augmentation>::nodeHeight(AVLNode* node)
 {
-    if (!node)
-        return;
-    
-    if (node->key == val)
-    {
-        if (node->rightChild)
-        {
-            AVLNode* n = node->rightChild;
-            while (n->leftChild)
-                n = n->leftChild;
-
-            *successorNode = n;
-        }
-    }
-    else if (node->key > val)
-    {
-        *successorNode = node;
-        _successor(val, node->leftChild, successorNode);
-    }
-    else
-    {
-        _successor(val, node->rightChild, successorNode);
-    }
+    return node ? node->height : -1;
 }
 
-template <typename T>
-typename AVLTree<T>::AVLNode* AVLTree<T>::leftLeftCase(AVLNode *node)
+template <typename T, typename Augmentation>
+typename AVLTree<T, Augmentation>::AVLNode* AVLTree<T, Augmentation>::leftLeftCase(AVLNode *node)
 {
     return rightRotation(node);
 }
 
-template <typename T>
-typename AVLTree<T>::AVLNode* AVLTree<T>::leftRightCase(AVLNode *node)
+template <typename T, typename Augmentation>
+typename AVLTree<T, Augmentation>::AVLNode* AVLTree<T, Augmentation>::leftRightCase(AVLNode *node)
 {
     node->leftChild = leftRotation(node->leftChild);
     return leftLeftCase(node);
 }
 
-template <typename T>
-typename AVLTree<T>::AVLNode* AVLTree<T>::rightLeftCase(AVLNode *node)
+template <typename T, typename Augmentation>
+typename AVLTree<T, Augmentation>::AVLNode* AVLTree<T, Augmentation>::rightLeftCase(AVLNode *node)
 {
     node->rightChild = rightRotation(node->rightChild);
     return rightRightCase(node);
 }
 
-template <typename T>
-typename AVLTree<T>::AVLNode* AVLTree<T>::rightRightCase(AVLNode *node)
+template <typename T, typename Augmentation>
+typename AVLTree<T, Augmentation>::AVLNode* AVLTree<T, Augmentation>::rightRightCase(AVLNode *node)
 {
     return leftRotation(node);
 }
 
-template <typename T>
-typename AVLTree<T>::AVLNode* AVLTree<T>::leftRotation(AVLNode *node)
+template <typename T, typename Augmentation>
+typename AVLTree<T, Augmentation>::AVLNode* AVLTree<T, Augmentation>::leftRotation(AVLNode *node)
 {
+    STATS_COUNT(treeRotations);
+
     auto* newParent = node->rightChild;
     node->rightChild = newParent->leftChild;
     newParent->leftChild = node;
@@ -433,9 +823,11 @@ typename AVLTree<T>::AVLNode* AVLTree<T>::leftRotation(AVLNode *node)
     return newParent;
 }
 
-template <typename T>
-typename AVLTree<T>::AVLNode* AVLTree<T>::rightRotation(AVLNode *node)
+template <typename T, typename Augmentation>
+typename AVLTree<T, Augmentation>::AVLNode* AVLTree<T, Augmentation>::rightRotation(AVLNode *node)
 {
+    STATS_COUNT(treeRotations);
+
     auto* newParent = node->leftChild;
     node->leftChild = newParent->rightChild;
     newParent->rightChild = node;
@@ -4,6 +4,7 @@
 #include "../Segment.h"
 
 #include <iostream>
+#include <vector>
 
 using namespace std;
 
@@ -24,23 +25,56 @@ int main()
     cout << endl;
 
 
-    cout << tree.predecessor(3)->value << endl;
-    cout << tree.successor(3)->value << endl;
+    cout << tree.predecessor(3)->key << endl;
+    cout << tree.successor(3)->key << endl;
     cout << endl;
 
     // cout << tree.m_root->value << endl;
     cout << endl;
 
-    // cout << tree.predecessor(0)->value << endl;
-    cout << tree.successor(0)->value << endl;
+    // cout << tree.predecessor(0)->key << endl;
+    cout << tree.successor(0)->key << endl;
     cout << endl;
 
-    cout << tree.predecessor(1)->value << endl;
-    cout << tree.successor(1)->value << endl;
+    cout << tree.predecessor(1)->key << endl;
+    cout << tree.successor(1)->key << endl;
     cout << endl;
 
-    cout << tree.predecessor(7)->value << endl;
-    // cout << tree.successor(7)->value << endl;
+    cout << tree.predecessor(7)->key << endl;
+    // cout << tree.successor(7)->key << endl;
+    cout << endl;
+
+    vector<int> sorted = { 1, 3, 5, 7, 9, 11, 13, 15, 17 };
+    AVLTree<int> bulk;
+    bulk.build(sorted.begin(), sorted.end());
+    cout << bulk.height() << endl;
+
+    AVLTree<int> lower, upper;
+    cout << bulk.split(9, lower, upper) << endl;
+    lower.inorder([](const int& x){
+        cout << x << " ";
+    });
+    cout << endl;
+    upper.inorder([](const int& x){
+        cout << x << " ";
+    });
+    cout << endl;
+
+    bulk.join(lower, 10, upper);
+    vector<int> batch = { 0, 2, 4, 19 };
+    bulk.insertSorted(batch.begin(), batch.end());
+    bulk.removeSorted(sorted.begin(), sorted.begin() + 3);
+    for (const auto& x : bulk)
+        cout << x << " ";
+    cout << endl;
+    cout << endl;
+
+    AVLTree<int, SubtreeSize> ranked;
+    ranked.build(sorted.begin(), sorted.end());
+    cout << ranked.size() << endl;
+    cout << ranked.rank(9) << endl;
+    cout << ranked.select(2)->key << endl;
+    cout << ranked.count(4, 13) << endl;
     cout << endl;
 
     AVLTree<Point> pointTree;
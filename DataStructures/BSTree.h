@@ -2,8 +2,10 @@
 
 #include "TreeNode.h"
 
-#include <functional>
+#include <algorithm>
 #include <iostream>
+#include <utility>
+#include <vector>
 
 template<typename T>
 class BSTree
@@ -39,7 +41,12 @@ public:
 
     bool find(const T& val) const;
 
-    void inorder(std::function<void (T)> traverser) const;
+    // Morris traversal: O(n) time and no extra memory, where a stack would
+    // need one entry per level of an unbalanced tree. The tree is threaded
+    // while it runs, hence not const: the visitor must not modify or query
+    // it, and no other thread may use it meanwhile.
+    template <typename Visitor>
+    void inorder(Visitor&& visitor);
     
     void insert(const T& value);
 
@@ -52,17 +59,7 @@ public:
 private:
     void destroy(TreeNode*& node);
 
-    bool _find(const T& val, TreeNode* node) const;
-    
-    void _insert(const T& val, TreeNode*& node);
-
     TreeNode* _findMin(TreeNode* node) const;
-    
-    void _remove(const T& val, TreeNode* & node);
-    
-    void _inorder(TreeNode* node, std::function<void (T)> traverser) const;
-
-    int _height(TreeNode* node) const;
 
 private:
     TreeNode* m_root;
@@ -89,28 +86,26 @@ inline bool BSTree<T>::isEmpty() const
 template <typename T>
 void BSTree<T>::destroy(TreeNode *&node)
 {
-    if (node)
+    // Rotates left children up so the tree unrolls into a right spine;
+    // no recursion, so degenerate trees cannot overflow the stack.
+    while (node)
     {
-        destroy(node->leftChild);
-        destroy(node->rightChild);
-        delete node;
+        if (node->leftChild)
+        {
+            auto* left = node->leftChild;
+            node->leftChild = left->rightChild;
+            left->rightChild = node;
+            node = left;
+        }
+        else
+        {
+            auto* right = node->rightChild;
+            delete node;
+            node = right;
+        }
     }
 }
 
-template <typename T>
-inline bool BSTree<T>::_find(const T &val, TreeNode *node) const
-{
-    if (!node)
-        return false;
-
-    if (val < node->value)
-        return _find(val, node->leftChild);
-    else if (val > node->value)
-        return _find(val, node->rightChild);
-    else
-        return true;
-}
-
 template <typename T>
 T BSTree<T>::findMin() const
 {
@@ -121,25 +116,104 @@ T BSTree<T>::findMin() const
 template <typename T>
 bool BSTree<T>::find(const T &val) const
 {
-    return _find(val, m_root);
+    auto* node = m_root;
+
+    while (node)
+    {
+        if (val < node->value)
+            node = node->leftChild;
+        else if (val > node->value)
+            node = node->rightChild;
+        else
+            return true;
+    }
+
+    return false;
 }
 
 template <typename T>
-void BSTree<T>::inorder(std::function<void(T)> traverser) const
+template <typename Visitor>
+void BSTree<T>::inorder(Visitor&& visitor)
 {
-    _inorder(m_root, traverser);
+    auto* node = m_root;
+
+    while (node)
+    {
+        if (!node->leftChild)
+        {
+            visitor(static_cast<const T&>(node->value));
+            node = node->rightChild;
+            continue;
+        }
+
+        auto* predecessor = node->leftChild;
+        while (predecessor->rightChild && predecessor->rightChild != node)
+            predecessor = predecessor->rightChild;
+
+        if (!predecessor->rightChild)
+        {
+            predecessor->rightChild = node;
+            node = node->leftChild;
+        }
+        else
+        {
+            predecessor->rightChild = nullptr;
+            visitor(static_cast<const T&>(node->value));
+            node = node->rightChild;
+        }
+    }
 }
 
 template <typename T>
 void BSTree<T>::insert(const T &value)
 {
-    _insert(value, m_root);
+    TreeNode** link = &m_root;
+
+    while (*link)
+    {
+        if (value < (*link)->value)
+            link = &(*link)->leftChild;
+        else if (value > (*link)->value)
+            link = &(*link)->rightChild;
+        else
+            return;
+    }
+
+    *link = new TreeNode(value);
 }
 
 template <typename T>
 void BSTree<T>::remove(const T &value)
 {
-    _remove(value, m_root);
+    TreeNode** link = &m_root;
+
+    while (*link)
+    {
+        if (value < (*link)->value)
+            link = &(*link)->leftChild;
+        else if (value > (*link)->value)
+            link = &(*link)->rightChild;
+        else
+            break;
+    }
+
+    if (!*link)
+        return;
+
+    auto* node = *link;
+    if (node->leftChild && node->rightChild)
+    {
+        TreeNode** minLink = &node->rightChild;
+        while ((*minLink)->leftChild)
+            minLink = &(*minLink)->leftChild;
+
+        node->value = (*minLink)->value;
+        link = minLink;
+        node = *link;
+    }
+
+    *link = node->leftChild ? node->leftChild : node->rightChild;
+    delete node;
 }
 
 template <typename T>
@@ -151,26 +225,28 @@ T BSTree<T>::removeMin()
 }
 
 template <typename T>
-inline int BSTree<T>::height() const
+int BSTree<T>::height() const
 {
-    return _height(m_root);
-}
+    // Heights are not stored, so this walks the whole tree with an explicit stack.
+    std::vector<std::pair<TreeNode*, int>> stack;
+    if (m_root)
+        stack.emplace_back(m_root, 0);
 
-template <typename T>
-void BSTree<T>::_insert(const T &val, TreeNode*& node)
-{
-    if (!node)
+    int maxDepth = -1;
+    while (!stack.empty())
     {
-        node = new TreeNode(val);
-    }
-    else if (val < node->value)
-    {
-        _insert(val, node->leftChild);
-    }
-    else if (val > node->value)
-    {
-        _insert(val, node->rightChild);
+        auto [node, depth] = stack.back();
+        stack.pop_back();
+
+        maxDepth = std::max(maxDepth, depth);
+
+        if (node->leftChild)
+            stack.emplace_back(node->leftChild, depth + 1);
+        if (node->rightChild)
+            stack.emplace_back(node->rightChild, depth + 1);
     }
+
+    return maxDepth;
 }
 
 template <typename T>
@@ -182,66 +258,3 @@ typename BSTree<T>::TreeNode *BSTree<T>::_findMin(TreeNode *node) const
     return node;
 }
 
-template <typename T>
-void BSTree<T>::_remove(const T &val, TreeNode *&node)
-{
-    if (!node)
-        return;
-
-    if (val < node->value)
-        _remove(val, node->leftChild);
-    else if (val > node->value)
-        _remove(val, node->rightChild);
-    else
-    {
-        if (!node->leftChild && !node->rightChild)
-        {
-            delete node;
-            node = nullptr;
-        }
-        else if (!node->leftChild)
-        {
-            auto* old = node;
-            node = old->rightChild;
-            delete old;
-        }
-        else if (!node->rightChild)
-        {
-            auto* old = node;
-            node = old->leftChild;
-            delete old;
-        }
-        else
-        {
-            auto* minNodeInRightSubTree = _findMin(node->rightChild);
-            node->value = minNodeInRightSubTree->value;
-            _remove(minNodeInRightSubTree->value, node->rightChild);
-        }
-    }
-}
-
-template <typename T>
-void BSTree<T>::_inorder(TreeNode *node, std::function<void (T)> traverser) const
-{
-    if (!node)
-    {
-        return;
-    }
-
-    if (node->leftChild)
-        _inorder(node->leftChild, traverser);
-
-    traverser(node->value);
-    
-    if (node->rightChild)
-        _inorder(node->rightChild, traverser);
-}
-
-template <typename T>
-int BSTree<T>::_height(TreeNode *node) const
-{
-    if (!node)
-        return -1;
-    
-    return std::max(_height(node->leftChild), _height(node->rightChild)) + 1;
-}
@@ -0,0 +1,480 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <new>
+
+// Lock-free ordered set (Fraser / Herlihy-Shavit skip list). A node is
+// removed logically by marking its level 0 link and unlinked afterwards by
+// whichever thread walks past it. Removed nodes are parked on a retired list
+// and only freed by the destructor or reclaim(), so references obtained by a
+// concurrent reader never dangle.
+//
+// Queries are weakly consistent: under concurrent updates they reflect some
+// state of the set between the call and the return.
+template <typename T>
+class ConcurrentSkipList
+{
+public:
+    static constexpr int MaxLevel = 32;
+
+    struct SkipNode
+    {
+        T key;
+
+        int topLevel;
+
+        SkipNode* retiredNext;
+
+        // topLevel + 1 links follow the node in the same allocation; bit 0 of
+        // a link marks the owning node as deleted at that level.
+        std::atomic<std::uintptr_t>* next;
+
+        SkipNode(const T& val, int level) :
+            key(val),
+            topLevel(level),
+            retiredNext(nullptr),
+            next(reinterpret_cast<std::atomic<std::uintptr_t>*>(this + 1))
+        {
+            for (int i = 0; i <= level; ++i)
+                new (&next[i]) std::atomic<std::uintptr_t>(0);
+        }
+    };
+
+public:
+    ConcurrentSkipList();
+
+    ~ConcurrentSkipList();
+
+    ConcurrentSkipList(const ConcurrentSkipList&) = delete;
+    ConcurrentSkipList& operator= (const ConcurrentSkipList&) = delete;
+
+    bool isEmpty() const;
+
+    bool find(const T& val) const;
+
+    // Return false if the key was already present / absent.
+    bool insert(const T& key);
+    bool remove(const T& key);
+
+    // Each returns false when there is no such key.
+    bool min(T& out) const;
+
+    bool predecessor(const T& val, T& out) const;
+    bool successor(const T& val, T& out) const;
+
+    // Atomically takes the smallest key: usable as a concurrent priority queue.
+    bool removeMin(T& out);
+
+    // Frees the retired nodes. Must not run concurrently with any other call.
+    void reclaim();
+
+private:
+    bool search(const T& key, SkipNode** preds, SkipNode** succs);
+
+    // Marks every level of node; true if this call performed the level 0 mark.
+    bool markDeleted(SkipNode* node);
+
+    void retire(SkipNode* node);
+
+    // Single-threaded sweep that unlinks every marked node on every level.
+    void unlinkMarked();
+
+    SkipNode* firstLive() const;
+
+    static SkipNode* createNode(const T& key, int level);
+    static void destroyNode(SkipNode* node);
+
+    static int randomLevel();
+
+    static SkipNode* pointer(std::uintptr_t link);
+    static bool isMarked(std::uintptr_t link);
+    static bool isDeleted(const SkipNode* node);
+
+private:
+    SkipNode* m_head;
+
+    std::atomic<SkipNode*> m_retired;
+};
+
+template <typename T>
+ConcurrentSkipList<T>::ConcurrentSkipList() :
+    m_head(createNode(T(), MaxLevel - 1)),
+    m_retired(nullptr)
+{
+}
+
+template <typename T>
+ConcurrentSkipList<T>::~ConcurrentSkipList()
+{
+    reclaim();
+
+    auto* node = m_head;
+    while (node)
+    {
+        auto* next = pointer(node->next[0].load(std::memory_order_relaxed));
+        destroyNode(node);
+        node = next;
+    }
+}
+
+template <typename T>
+inline bool ConcurrentSkipList<T>::isEmpty() const
+{
+    return !firstLive();
+}
+
+template <typename T>
+bool ConcurrentSkipList<T>::find(const T& val) const
+{
+    SkipNode* pred = m_head;
+    SkipNode* curr = nullptr;
+
+    for (int level = MaxLevel - 1; level >= 0; --level)
+    {
+        curr = pointer(pred->next[level].load(std::memory_order_acquire));
+        while (curr && curr->key < val)
+        {
+            pred = curr;
+            curr = pointer(curr->next[level].load(std::memory_order_acquire));
+        }
+    }
+
+    return curr && !(val < curr->key) && !isDeleted(curr);
+}
+
+template <typename T>
+bool ConcurrentSkipList<T>::insert(const T& key)
+{
+    SkipNode* preds[MaxLevel];
+    SkipNode* succs[MaxLevel];
+
+    int topLevel = randomLevel();
+    SkipNode* node = nullptr;
+
+    while (true)
+    {
+        if (search(key, preds, succs))
+        {
+            if (node)
+                destroyNode(node);
+            return false;
+        }
+
+        if (!node)
+            node = createNode(key, topLevel);
+
+        for (int level = 0; level <= topLevel; ++level)
+            node->next[level].store(reinterpret_cast<std::uintptr_t>(succs[level]), std::memory_order_relaxed);
+
+        auto expected = reinterpret_cast<std::uintptr_t>(succs[0]);
+        if (preds[0]->next[0].compare_exchange_strong(expected, reinterpret_cast<std::uintptr_t>(node), std::memory_order_release, std::memory_order_relaxed))
+            break;
+    }
+
+    // The node is in the set now; the upper levels are only shortcuts.
+    for (int level = 1; level <= topLevel; ++level)
+    {
+        while (true)
+        {
+            auto link = node->next[level].load(std::memory_order_acquire);
+            if (isMarked(link))
+                return true;
+
+            auto succ = reinterpret_cast<std::uintptr_t>(succs[level]);
+            if (link != succ && !node->next[level].compare_exchange_strong(link, succ, std::memory_order_acq_rel))
+                continue;
+
+            auto expected = succ;
+            if (preds[level]->next[level].compare_exchange_strong(expected, reinterpret_cast<std::uintptr_t>(node), std::memory_order_acq_rel, std::memory_order_relaxed))
+            {
+                // removed while being linked: make sure it does not stay reachable
+                if (isMarked(node->next[level].load(std::memory_order_acquire)))
+                {
+                    search(key, preds, succs);
+                    return true;
+                }
+                break;
+            }
+
+            search(key, preds, succs);
+            if (succs[0] != node)
+                return true;
+        }
+    }
+
+    return true;
+}
+
+template <typename T>
+bool ConcurrentSkipList<T>::remove(const T& key)
+{
+    SkipNode* preds[MaxLevel];
+    SkipNode* succs[MaxLevel];
+
+    if (!search(key, preds, succs))
+        return false;
+
+    SkipNode* victim = succs[0];
+    if (!markDeleted(victim))
+        return false;
+
+    search(key, preds, succs);
+    retire(victim);
+
+    return true;
+}
+
+template <typename T>
+bool ConcurrentSkipList<T>::min(T& out) const
+{
+    auto* node = firstLive();
+    if (!node)
+        return false;
+
+    out = node->key;
+    return true;
+}
+
+template <typename T>
+bool ConcurrentSkipList<T>::predecessor(const T& val, T& out) const
+{
+    // Only live nodes become pred, so the last one seen on level 0 is the answer.
+    SkipNode* pred = m_head;
+
+    for (int level = MaxLevel - 1; level >= 0; --level)
+    {
+        auto* curr = pointer(pred->next[level].load(std::memory_order_acquire));
+        while (curr && curr->key < val)
+        {
+            if (!isDeleted(curr))
+                pred = curr;
+            curr = pointer(curr->next[level].load(std::memory_order_acquire));
+        }
+    }
+
+    if (pred == m_head)
+        return false;
+
+    out = pred->key;
+    return true;
+}
+
+template <typename T>
+bool ConcurrentSkipList<T>::successor(const T& val, T& out) const
+{
+    SkipNode* pred = m_head;
+    SkipNode* curr = nullptr;
+
+    for (int level = MaxLevel - 1; level >= 0; --level)
+    {
+        curr = pointer(pred->next[level].load(std::memory_order_acquire));
+        while (curr && !(val < curr->key))
+        {
+            pred = curr;
+            curr = pointer(curr->next[level].load(std::memory_order_acquire));
+        }
+    }
+
+    while (curr && isDeleted(curr))
+        curr = pointer(curr->next[0].load(std::memory_order_acquire));
+
+    if (!curr)
+        return false;
+
+    out = curr->key;
+    return true;
+}
+
+template <typename T>
+bool ConcurrentSkipList<T>::removeMin(T& out)
+{
+    SkipNode* preds[MaxLevel];
+    SkipNode* succs[MaxLevel];
+
+    while (true)
+    {
+        auto* node = firstLive();
+        if (!node)
+            return false;
+
+        if (markDeleted(node))
+        {
+            out = node->key;
+            search(node->key, preds, succs);
+            retire(node);
+            return true;
+        }
+    }
+}
+
+template <typename T>
+void ConcurrentSkipList<T>::reclaim()
+{
+    unlinkMarked();
+
+    auto* node = m_retired.exchange(nullptr, std::memory_order_acquire);
+    while (node)
+    {
+        auto* next = node->retiredNext;
+        destroyNode(node);
+        node = next;
+    }
+}
+
+template <typename T>
+bool ConcurrentSkipList<T>::search(const T& key, SkipNode** preds, SkipNode** succs)
+{
+retry:
+    SkipNode* pred = m_head;
+    SkipNode* curr = nullptr;
+
+    for (int level = MaxLevel - 1; level >= 0; --level)
+    {
+        curr = pointer(pred->next[level].load(std::memory_order_acquire));
+        while (curr)
+        {
+            auto link = curr->next[level].load(std::memory_order_acquire);
+
+            // unlink nodes marked at this level on the way
+            while (isMarked(link))
+            {
+                auto expected = reinterpret_cast<std::uintptr_t>(curr);
+                if (!pred->next[level].compare_exchange_strong(expected, link & ~std::uintptr_t(1), std::memory_order_acq_rel))
+                    goto retry;
+
+                curr = pointer(link);
+                if (!curr)
+                    break;
+
+                link = curr->next[level].load(std::memory_order_acquire);
+            }
+
+            if (!curr || !(curr->key < key))
+                break;
+
+            pred = curr;
+            curr = pointer(link);
+        }
+
+        preds[level] = pred;
+        succs[level] = curr;
+    }
+
+    return curr && !(key < curr->key);
+}
+
+template <typename T>
+bool ConcurrentSkipList<T>::markDeleted(SkipNode* node)
+{
+    for (int level = node->topLevel; level >= 1; --level)
+    {
+        auto link = node->next[level].load(std::memory_order_acquire);
+        while (!isMarked(link))
+            node->next[level].compare_exchange_weak(link, link | 1, std::memory_order_acq_rel);
+    }
+
+    auto link = node->next[0].load(std::memory_order_acquire);
+    while (!isMarked(link))
+    {
+        if (node->next[0].compare_exchange_weak(link, link | 1, std::memory_order_acq_rel))
+            return true;
+    }
+
+    return false;
+}
+
+template <typename T>
+void ConcurrentSkipList<T>::retire(SkipNode* node)
+{
+    auto* head = m_retired.load(std::memory_order_relaxed);
+    do
+    {
+        node->retiredNext = head;
+    } while (!m_retired.compare_exchange_weak(head, node, std::memory_order_release, std::memory_order_relaxed));
+}
+
+template <typename T>
+void ConcurrentSkipList<T>::unlinkMarked()
+{
+    for (int level = 0; level < MaxLevel; ++level)
+    {
+        SkipNode* pred = m_head;
+        SkipNode* curr = pointer(pred->next[level].load(std::memory_order_relaxed));
+
+        while (curr)
+        {
+            auto link = curr->next[level].load(std::memory_order_relaxed);
+
+            if (isMarked(link))
+            {
+                pred->next[level].store(link & ~std::uintptr_t(1), std::memory_order_relaxed);
+            }
+            else
+            {
+                pred = curr;
+            }
+
+            curr = pointer(link);
+        }
+    }
+}
+
+template <typename T>
+typename ConcurrentSkipList<T>::SkipNode* ConcurrentSkipList<T>::firstLive() const
+{
+    auto* node = pointer(m_head->next[0].load(std::memory_order_acquire));
+    while (node && isDeleted(node))
+        node = pointer(node->next[0].load(std::memory_order_acquire));
+
+    return node;
+}
+
+template <typename T>
+typename ConcurrentSkipList<T>::SkipNode* ConcurrentSkipList<T>::createNode(const T& key, int level)
+{
+    void* memory = ::operator new(sizeof(SkipNode) + (level + 1) * sizeof(std::atomic<std::uintptr_t>));
+    return new (memory) SkipNode(key, level);
+}
+
+template <typename T>
+void ConcurrentSkipList<T>::destroyNode(SkipNode* node)
+{
+    node->~SkipNode();
+    ::operator delete(node);
+}
+
+template <typename T>
+int ConcurrentSkipList<T>::randomLevel()
+{
+    // xorshift per thread; each level is kept with probability 1/2
+    thread_local std::uint32_t state = 0x9e3779b9u ^ static_cast<std::uint32_t>(reinterpret_cast<std::uintptr_t>(&state));
+
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+
+    int level = 0;
+    for (auto bits = state; (bits & 1) && level < MaxLevel - 1; bits >>= 1)
+        ++level;
+
+    return level;
+}
+
+template <typename T>
+inline typename ConcurrentSkipList<T>::SkipNode* ConcurrentSkipList<T>::pointer(std::uintptr_t link)
+{
+    return reinterpret_cast<SkipNode*>(link & ~std::uintptr_t(1));
+}
+
+template <typename T>
+inline bool ConcurrentSkipList<T>::isMarked(std::uintptr_t link)
+{
+    return link & 1;
+}
+
+template <typename T>
+inline bool ConcurrentSkipList<T>::isDeleted(const SkipNode* node)
+{
+    return isMarked(node->next[0].load(std::memory_order_acquire));
+}
@@ -0,0 +1,74 @@
+#include "AVLTree.h"
+#include "ConcurrentSkipList.h"
+
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Mixed insert / remove / removeMin workload over a small key range, so that
+// all threads keep hitting the same region of the set.
+template <typename Insert, typename Remove, typename RemoveMin>
+double run(int nThreads, int opsPerThread, Insert insert, Remove remove, RemoveMin removeMin)
+{
+    vector<thread> workers;
+
+    auto start = chrono::steady_clock::now();
+
+    for (int t = 0; t < nThreads; ++t)
+    {
+        workers.emplace_back([=]() {
+            mt19937 gen(t);
+            uniform_int_distribution<int> key(0, 1 << 16);
+
+            for (int i = 0; i < opsPerThread; ++i)
+            {
+                int op = i % 4;
+                if (op < 2)
+                    insert(key(gen));
+                else if (op == 2)
+                    remove(key(gen));
+                else
+                    removeMin();
+            }
+        });
+    }
+
+    for (auto& worker : workers)
+        worker.join();
+
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+    return nThreads * opsPerThread / elapsed.count() / 1e6;
+}
+
+int main()
+{
+    const int opsPerThread = 200000;
+
+    cout << "threads  skiplist(Mops/s)  mutex+AVLTree(Mops/s)" << endl;
+
+    for (int nThreads = 1; nThreads <= 2 * (int)thread::hardware_concurrency() && nThreads <= 32; nThreads *= 2)
+    {
+        ConcurrentSkipList<int> list;
+        double skipList = run(nThreads, opsPerThread,
+            [&list](int key) { list.insert(key); },
+            [&list](int key) { list.remove(key); },
+            [&list]() { int key; list.removeMin(key); });
+
+        AVLTree<int> tree;
+        mutex treeMutex;
+        double lockedTree = run(nThreads, opsPerThread,
+            [&](int key) { lock_guard<mutex> lock(treeMutex); tree.insert(key); },
+            [&](int key) { lock_guard<mutex> lock(treeMutex); tree.remove(key); },
+            [&]() { int key; lock_guard<mutex> lock(treeMutex); tree.removeMin(key); });
+
+        cout << nThreads << "  " << skipList << "  " << lockedTree << endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,54 @@
+#include "ConcurrentSkipList.h"
+
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+int main()
+{
+    ConcurrentSkipList<int> list;
+
+    vector<thread> producers;
+    for (int t = 0; t < 4; ++t)
+    {
+        producers.emplace_back([&list, t]() {
+            for (int i = 0; i < 1000; ++i)
+                list.insert(4 * i + t);
+        });
+    }
+
+    for (auto& producer : producers)
+        producer.join();
+
+    int val;
+    cout << list.min(val) << " " << val << endl;
+    cout << list.find(3999) << " " << list.find(4000) << endl;
+    cout << list.successor(10, val) << " " << val << endl;
+    cout << list.predecessor(10, val) << " " << val << endl;
+    cout << list.remove(11) << " " << list.remove(11) << endl;
+    cout << list.successor(10, val) << " " << val << endl;
+    cout << endl;
+
+    vector<int> taken(4, 0);
+    vector<thread> consumers;
+    for (int t = 0; t < 4; ++t)
+    {
+        consumers.emplace_back([&list, &taken, t]() {
+            int key;
+            while (list.removeMin(key))
+                ++taken[t];
+        });
+    }
+
+    for (auto& consumer : consumers)
+        consumer.join();
+
+    cout << taken[0] + taken[1] + taken[2] + taken[3] << endl;
+    cout << list.isEmpty() << endl;
+
+    list.reclaim();
+
+    return 0;
+}
@@ -0,0 +1,374 @@
+#pragma once
+
+#include "../Point.h"
+#include "../Stats.h"
+
+#include <algorithm>
+#include <numeric>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Static 2D kd-tree over a point set. The tree is implicit: node i has
+// children 2i + 1 and 2i + 2, every node splits its index range in half, and
+// only the split value and axis are stored per node. The points themselves are
+// permuted into one contiguous array, so each leaf bucket is a contiguous run.
+//
+// Query results are indices into the vector passed to the constructor.
+class KDTree
+{
+public:
+    explicit KDTree(const std::vector<Point>& points, int leafSize = 8, int nThreads = 1);
+
+    int size() const;
+
+    // The k nearest points, closest first (ties by index).
+    void nearest(const Point& q, int k, std::vector<int>& ids) const;
+
+    // Points with |p - q| <= r, in no particular order.
+    void radius(const Point& q, double r, std::vector<int>& ids) const;
+
+    // Points inside the closed box [lo, hi], in no particular order.
+    void rectangle(const Point& lo, const Point& hi, std::vector<int>& ids) const;
+
+    // Batched queries. Queries are processed in leaf order so consecutive
+    // ones walk the same paths, split into contiguous chunks over nThreads.
+    // ids[i * k .. i * k + k) answers queries[i], padded with -1.
+    void nearest(const std::vector<Point>& queries, int k, std::vector<int>& ids, int nThreads = 1) const;
+
+    // ids[offsets[i] .. offsets[i + 1]) answers queries[i].
+    void radius(const std::vector<Point>& queries, double r, std::vector<int>& ids, std::vector<int>& offsets, int nThreads = 1) const;
+
+private:
+    struct Neighbour
+    {
+        double squaredDistance;
+        int id;
+
+        bool operator< (const Neighbour& other) const
+        {
+            return squaredDistance < other.squaredDistance || (squaredDistance == other.squaredDistance && id < other.id);
+        }
+    };
+
+    void build(int node, int lo, int hi, int depth, int parallelDepth);
+
+    void nearest(int node, int lo, int hi, int depth, const Point& q, int k, std::vector<Neighbour>& heap) const;
+
+    void radius(int node, int lo, int hi, int depth, const Point& q, double r, std::vector<int>& ids) const;
+
+    void rectangle(int node, int lo, int hi, int depth, const Point& lo_, const Point& hi_, std::vector<int>& ids) const;
+
+    // Leaf a query point falls into; used to order batched queries.
+    int leafOf(const Point& q) const;
+
+    // Query indices sorted by leaf, cut into nThreads contiguous chunks;
+    // worker(chunk, first, last) runs once per chunk.
+    template <typename Worker>
+    void forEachChunk(const std::vector<Point>& queries, int nThreads, Worker worker) const;
+
+    static double coordinate(const Point& p, int axis);
+    static double squaredDistance(const Point& p, const Point& q);
+
+private:
+    struct Entry
+    {
+        Point p;
+        int id;
+    };
+
+    std::vector<Entry> m_entries;
+
+    std::vector<double> m_split;
+    std::vector<unsigned char> m_axis;
+
+    int m_depth = 0;
+};
+
+inline KDTree::KDTree(const std::vector<Point>& points, int leafSize, int nThreads) :
+    m_entries(points.size())
+{
+    TRACE_SPAN("KDTree");
+
+    for (int i = 0; i < points.size(); ++i)
+        m_entries[i] = {points[i], i};
+
+    int n = static_cast<int>(points.size());
+    while ((n >> m_depth) > std::max(1, leafSize))
+        ++m_depth;
+
+    m_split.resize((1 << m_depth) - 1);
+    m_axis.resize((1 << m_depth) - 1);
+
+    int parallelDepth = 0;
+    while ((1 << parallelDepth) < nThreads)
+        ++parallelDepth;
+
+    build(0, 0, n, 0, parallelDepth);
+}
+
+inline int KDTree::size() const
+{
+    return static_cast<int>(m_entries.size());
+}
+
+inline void KDTree::nearest(const Point& q, int k, std::vector<int>& ids) const
+{
+    std::vector<Neighbour> heap;
+    heap.reserve(k);
+
+    if (k > 0)
+        nearest(0, 0, size(), 0, q, k, heap);
+
+    std::sort_heap(heap.begin(), heap.end());
+
+    for (const auto& neighbour : heap)
+        ids.push_back(neighbour.id);
+}
+
+inline void KDTree::radius(const Point& q, double r, std::vector<int>& ids) const
+{
+    radius(0, 0, size(), 0, q, r, ids);
+}
+
+inline void KDTree::rectangle(const Point& lo, const Point& hi, std::vector<int>& ids) const
+{
+    rectangle(0, 0, size(), 0, lo, hi, ids);
+}
+
+inline void KDTree::nearest(const std::vector<Point>& queries, int k, std::vector<int>& ids, int nThreads) const
+{
+    ids.assign(queries.size() * std::max(k, 0), -1);
+
+    forEachChunk(queries, nThreads, [&](int, const int* first, const int* last) {
+        std::vector<Neighbour> heap;
+        heap.reserve(k);
+
+        for (; first != last; ++first)
+        {
+            heap.clear();
+            if (k > 0)
+                nearest(0, 0, size(), 0, queries[*first], k, heap);
+            std::sort_heap(heap.begin(), heap.end());
+
+            for (int j = 0; j < heap.size(); ++j)
+                ids[static_cast<std::size_t>(*first) * k + j] = heap[j].id;
+        }
+    });
+}
+
+inline void KDTree::radius(const std::vector<Point>& queries, double r, std::vector<int>& ids, std::vector<int>& offsets, int nThreads) const
+{
+    // Every worker collects its chunk into one buffer plus per-query spans;
+    // the spans are then laid out in query order.
+    struct Span
+    {
+        int query;
+        int begin;
+        int end;
+    };
+
+    std::vector<std::vector<int>> chunkIds(std::max(1, nThreads));
+    std::vector<std::vector<Span>> chunkSpans(std::max(1, nThreads));
+
+    forEachChunk(queries, nThreads, [&](int chunk, const int* first, const int* last) {
+        auto& local = chunkIds[chunk];
+        auto& spans = chunkSpans[chunk];
+
+        for (; first != last; ++first)
+        {
+            int begin = static_cast<int>(local.size());
+            radius(0, 0, size(), 0, queries[*first], r, local);
+            spans.push_back({*first, begin, static_cast<int>(local.size())});
+        }
+    });
+
+    offsets.assign(queries.size() + 1, 0);
+    for (const auto& spans : chunkSpans)
+        for (const auto& span : spans)
+            offsets[span.query + 1] = span.end - span.begin;
+
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+    ids.resize(offsets.back());
+    for (int c = 0; c < chunkSpans.size(); ++c)
+        for (const auto& span : chunkSpans[c])
+            std::copy(chunkIds[c].begin() + span.begin, chunkIds[c].begin() + span.end, ids.begin() + offsets[span.query]);
+}
+
+inline void KDTree::build(int node, int lo, int hi, int depth, int parallelDepth)
+{
+    if (depth == m_depth)
+        return;
+
+    Point minimum = m_entries[lo].p, maximum = minimum;
+    for (int i = lo + 1; i < hi; ++i)
+    {
+        const auto& p = m_entries[i].p;
+        minimum = {std::min(minimum.x, p.x), std::min(minimum.y, p.y)};
+        maximum = {std::max(maximum.x, p.x), std::max(maximum.y, p.y)};
+    }
+
+    // split the wider side of the bounding box at the median
+    int axis = (maximum.x - minimum.x >= maximum.y - minimum.y) ? 0 : 1;
+    int mid = lo + (hi - lo) / 2;
+
+    std::nth_element(m_entries.begin() + lo, m_entries.begin() + mid, m_entries.begin() + hi, [axis](const Entry& a, const Entry& b) {
+        return coordinate(a.p, axis) < coordinate(b.p, axis);
+    });
+
+    m_axis[node] = static_cast<unsigned char>(axis);
+    m_split[node] = coordinate(m_entries[mid].p, axis);
+
+    if (depth < parallelDepth)
+    {
+        std::thread left([=]() {
+            TRACE_SPAN("build");
+            build(2 * node + 1, lo, mid, depth + 1, parallelDepth);
+        });
+        build(2 * node + 2, mid, hi, depth + 1, parallelDepth);
+        left.join();
+    }
+    else
+    {
+        build(2 * node + 1, lo, mid, depth + 1, parallelDepth);
+        build(2 * node + 2, mid, hi, depth + 1, parallelDepth);
+    }
+}
+
+inline void KDTree::nearest(int node, int lo, int hi, int depth, const Point& q, int k, std::vector<Neighbour>& heap) const
+{
+    if (depth == m_depth)
+    {
+        for (int i = lo; i < hi; ++i)
+        {
+            Neighbour candidate{squaredDistance(q, m_entries[i].p), m_entries[i].id};
+
+            if (heap.size() < k)
+            {
+                heap.push_back(candidate);
+                std::push_heap(heap.begin(), heap.end());
+            }
+            else if (candidate < heap.front())
+            {
+                std::pop_heap(heap.begin(), heap.end());
+                heap.back() = candidate;
+                std::push_heap(heap.begin(), heap.end());
+            }
+        }
+        return;
+    }
+
+    int mid = lo + (hi - lo) / 2;
+    double diff = coordinate(q, m_axis[node]) - m_split[node];
+
+    if (diff < 0.)
+    {
+        nearest(2 * node + 1, lo, mid, depth + 1, q, k, heap);
+        if (heap.size() < k || diff * diff <= heap.front().squaredDistance)
+            nearest(2 * node + 2, mid, hi, depth + 1, q, k, heap);
+    }
+    else
+    {
+        nearest(2 * node + 2, mid, hi, depth + 1, q, k, heap);
+        if (heap.size() < k || diff * diff <= heap.front().squaredDistance)
+            nearest(2 * node + 1, lo, mid, depth + 1, q, k, heap);
+    }
+}
+
+inline void KDTree::radius(int node, int lo, int hi, int depth, const Point& q, double r, std::vector<int>& ids) const
+{
+    if (depth == m_depth)
+    {
+        for (int i = lo; i < hi; ++i)
+            if (squaredDistance(q, m_entries[i].p) <= r * r)
+                ids.push_back(m_entries[i].id);
+        return;
+    }
+
+    int mid = lo + (hi - lo) / 2;
+    double diff = coordinate(q, m_axis[node]) - m_split[node];
+
+    if (diff <= r)
+        radius(2 * node + 1, lo, mid, depth + 1, q, r, ids);
+    if (diff >= -r)
+        radius(2 * node + 2, mid, hi, depth + 1, q, r, ids);
+}
+
+inline void KDTree::rectangle(int node, int lo, int hi, int depth, const Point& lo_, const Point& hi_, std::vector<int>& ids) const
+{
+    if (depth == m_depth)
+    {
+        for (int i = lo; i < hi; ++i)
+        {
+            const auto& p = m_entries[i].p;
+            if (p.x >= lo_.x && p.x <= hi_.x && p.y >= lo_.y && p.y <= hi_.y)
+                ids.push_back(m_entries[i].id);
+        }
+        return;
+    }
+
+    int mid = lo + (hi - lo) / 2;
+    int axis = m_axis[node];
+
+    if (coordinate(lo_, axis) <= m_split[node])
+        rectangle(2 * node + 1, lo, mid, depth + 1, lo_, hi_, ids);
+    if (coordinate(hi_, axis) >= m_split[node])
+        rectangle(2 * node + 2, mid, hi, depth + 1, lo_, hi_, ids);
+}
+
+inline int KDTree::leafOf(const Point& q) const
+{
+    int node = 0;
+    for (int depth = 0; depth < m_depth; ++depth)
+        node = 2 * node + (coordinate(q, m_axis[node]) < m_split[node] ? 1 : 2);
+
+    return node;
+}
+
+template <typename Worker>
+void KDTree::forEachChunk(const std::vector<Point>& queries, int nThreads, Worker worker) const
+{
+    std::vector<std::pair<int, int>> keyed(queries.size());
+    for (int i = 0; i < queries.size(); ++i)
+        keyed[i] = {leafOf(queries[i]), i};
+
+    std::sort(keyed.begin(), keyed.end());
+
+    std::vector<int> order(queries.size());
+    for (int i = 0; i < keyed.size(); ++i)
+        order[i] = keyed[i].second;
+
+    nThreads = std::max(1, std::min<int>(nThreads, order.size()));
+
+    auto tracedWorker = [&worker](int t, const int* first, const int* last) {
+        TRACE_SPAN("queries");
+        worker(t, first, last);
+    };
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < nThreads; ++t)
+    {
+        const int* first = order.data() + order.size() * t / nThreads;
+        const int* last = order.data() + order.size() * (t + 1) / nThreads;
+
+        if (t + 1 == nThreads)
+            tracedWorker(t, first, last);
+        else
+            workers.emplace_back(tracedWorker, t, first, last);
+    }
+
+    for (auto& w : workers)
+        w.join();
+}
+
+inline double KDTree::coordinate(const Point& p, int axis)
+{
+    return axis == 0 ? p.x : p.y;
+}
+
+inline double KDTree::squaredDistance(const Point& p, const Point& q)
+{
+    Point d = p - q;
+    return d & d;
+}
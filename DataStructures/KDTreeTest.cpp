@@ -0,0 +1,50 @@
+#include "KDTree.h"
+
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+int main()
+{
+    vector<Point> points = { {1.1, 1.2}, {-2, 4}, {-3, 12}, {4, -16}, {12, 8}, {0.7, 1.2}, {3.5, 2.4} };
+
+    KDTree tree(points, 2);
+
+    vector<int> ids;
+    tree.nearest(Point{1, 1}, 3, ids);
+    for (int id : ids)
+        cout << id << " ";
+    cout << endl;
+
+    ids.clear();
+    tree.radius(Point{0, 0}, 5., ids);
+    for (int id : ids)
+        cout << id << " ";
+    cout << endl;
+
+    ids.clear();
+    tree.rectangle(Point{-5, 0}, Point{5, 13}, ids);
+    for (int id : ids)
+        cout << id << " ";
+    cout << endl;
+    cout << endl;
+
+    vector<Point> queries = { {0, 0}, {10, 10}, {-3, 11} };
+    vector<int> offsets;
+
+    tree.nearest(queries, 2, ids, 2);
+    for (int id : ids)
+        cout << id << " ";
+    cout << endl;
+
+    tree.radius(queries, 3., ids, offsets, 2);
+    for (int i = 0; i < queries.size(); ++i)
+    {
+        for (int j = offsets[i]; j < offsets[i + 1]; ++j)
+            cout << ids[j] << " ";
+        cout << endl;
+    }
+
+    return 0;
+}
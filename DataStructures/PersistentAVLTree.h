@@ -0,0 +1,343 @@
+#pragma once
+
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <vector>
+
+// Path-copying AVL tree: every update returns a new version and shares all
+// untouched nodes with the version it was derived from. Nodes are immutable
+// once built and owned by the tree, so any number of threads may query any
+// versions concurrently without locking, as long as no update runs at the
+// same time.
+template <typename T, typename Compare = std::less<T>>
+class PersistentAVLTree
+{
+public:
+    struct AVLNode
+    {
+        int height;
+
+        T key;
+
+        const AVLNode* leftChild;
+        const AVLNode* rightChild;
+
+        AVLNode(const T& val, const AVLNode* left, const AVLNode* right) :
+            height(1 + std::max(left ? left->height : -1, right ? right->height : -1)),
+            key(val),
+            leftChild(left),
+            rightChild(right)
+        {
+        }
+    };
+
+public:
+    // Version 0 is the empty tree.
+    explicit PersistentAVLTree(Compare less = Compare());
+
+    int versionCount() const;
+
+    // Both return the id of the new version derived from version.
+    int insert(int version, const T& key);
+    int remove(int version, const T& key);
+
+    bool isEmpty(int version) const;
+
+    int height(int version) const;
+
+    const AVLNode* root(int version) const;
+
+    const AVLNode* min(int version) const;
+    const AVLNode* max(int version) const;
+
+    bool find(int version, const T& val) const;
+
+    const AVLNode* predecessor(int version, const T& val) const;
+    const AVLNode* successor(int version, const T& val) const;
+
+    // First key for which before(key) is false, assuming the keys are
+    // partitioned by before. Does not touch the comparator.
+    template <typename Before>
+    const AVLNode* lowerBound(int version, Before before) const;
+
+    // The comparator may carry state, e.g. the sweep position, that the
+    // caller moves between updates.
+    Compare& comparator();
+
+private:
+    const AVLNode* makeNode(const T& key, const AVLNode* left, const AVLNode* right);
+
+    const AVLNode* balance(const T& key, const AVLNode* left, const AVLNode* right);
+
+    const AVLNode* _insert(const T& val, const AVLNode* node);
+
+    const AVLNode* _remove(const T& val, const AVLNode* node);
+
+    const AVLNode* _removeMin(const AVLNode* node);
+
+    static int nodeHeight(const AVLNode* node);
+
+private:
+    Compare m_less;
+
+    std::deque<AVLNode> m_nodes;
+    std::vector<const AVLNode*> m_roots;
+};
+
+template <typename T, typename Compare>
+PersistentAVLTree<T, Compare>::PersistentAVLTree(Compare less) :
+    m_less(less),
+    m_roots(1, nullptr)
+{
+}
+
+template <typename T, typename Compare>
+inline int PersistentAVLTree<T, Compare>::versionCount() const
+{
+    return static_cast<int>(m_roots.size());
+}
+
+template <typename T, typename Compare>
+int PersistentAVLTree<T, Compare>::insert(int version, const T& key)
+{
+    m_roots.push_back(_insert(key, m_roots[version]));
+    return versionCount() - 1;
+}
+
+template <typename T, typename Compare>
+int PersistentAVLTree<T, Compare>::remove(int version, const T& key)
+{
+    m_roots.push_back(_remove(key, m_roots[version]));
+    return versionCount() - 1;
+}
+
+template <typename T, typename Compare>
+inline bool PersistentAVLTree<T, Compare>::isEmpty(int version) const
+{
+    return !m_roots[version];
+}
+
+template <typename T, typename Compare>
+inline int PersistentAVLTree<T, Compare>::height(int version) const
+{
+    return nodeHeight(m_roots[version]);
+}
+
+template <typename T, typename Compare>
+inline const typename PersistentAVLTree<T, Compare>::AVLNode* PersistentAVLTree<T, Compare>::root(int version) const
+{
+    return m_roots[version];
+}
+
+template <typename T, typename Compare>
+const typename PersistentAVLTree<T, Compare>::AVLNode* PersistentAVLTree<T, Compare>::min(int version) const
+{
+    const AVLNode* node = m_roots[version];
+    while (node && node->leftChild)
+        node = node->leftChild;
+
+    return node;
+}
+
+template <typename T, typename Compare>
+const typename PersistentAVLTree<T, Compare>::AVLNode* PersistentAVLTree<T, Compare>::max(int version) const
+{
+    const AVLNode* node = m_roots[version];
+    while (node && node->rightChild)
+        node = node->rightChild;
+
+    return node;
+}
+
+template <typename T, typename Compare>
+bool PersistentAVLTree<T, Compare>::find(int version, const T& val) const
+{
+    const AVLNode* node = m_roots[version];
+
+    while (node)
+    {
+        if (m_less(val, node->key))
+            node = node->leftChild;
+        else if (m_less(node->key, val))
+            node = node->rightChild;
+        else
+            return true;
+    }
+
+    return false;
+}
+
+template <typename T, typename Compare>
+const typename PersistentAVLTree<T, Compare>::AVLNode* PersistentAVLTree<T, Compare>::predecessor(int version, const T& val) const
+{
+    const AVLNode* predecessorNode = nullptr;
+    const AVLNode* node = m_roots[version];
+
+    while (node)
+    {
+        if (m_less(node->key, val))
+        {
+            predecessorNode = node;
+            node = node->rightChild;
+        }
+        else
+        {
+            node = node->leftChild;
+        }
+    }
+
+    return predecessorNode;
+}
+
+template <typename T, typename Compare>
+const typename PersistentAVLTree<T, Compare>::AVLNode* PersistentAVLTree<T, Compare>::successor(int version, const T& val) const
+{
+    const AVLNode* successorNode = nullptr;
+    const AVLNode* node = m_roots[version];
+
+    while (node)
+    {
+        if (m_less(val, node->key))
+        {
+            successorNode = node;
+            node = node->leftChild;
+        }
+        else
+        {
+            node = node->rightChild;
+        }
+    }
+
+    return successorNode;
+}
+
+template <typename T, typename Compare>
+template <typename Before>
+const typename PersistentAVLTree<T, Compare>::AVLNode* PersistentAVLTree<T, Compare>::lowerBound(int version, Before before) const
+{
+    const AVLNode* result = nullptr;
+    const AVLNode* node = m_roots[version];
+
+    while (node)
+    {
+        if (before(node->key))
+        {
+            node = node->rightChild;
+        }
+        else
+        {
+            result = node;
+            node = node->leftChild;
+        }
+    }
+
+    return result;
+}
+
+template <typename T, typename Compare>
+inline Compare& PersistentAVLTree<T, Compare>::comparator()
+{
+    return m_less;
+}
+
+template <typename T, typename Compare>
+inline const typename PersistentAVLTree<T, Compare>::AVLNode* PersistentAVLTree<T, Compare>::makeNode(const T& key, const AVLNode* left, const AVLNode* right)
+{
+    m_nodes.emplace_back(key, left, right);
+    return &m_nodes.back();
+}
+
+template <typename T, typename Compare>
+const typename PersistentAVLTree<T, Compare>::AVLNode* PersistentAVLTree<T, Compare>::balance(const T& key, const AVLNode* left, const AVLNode* right)
+{
+    int leftHeight = nodeHeight(left);
+    int rightHeight = nodeHeight(right);
+
+    if (leftHeight > rightHeight + 1)
+    {
+        // left left case
+        if (nodeHeight(left->leftChild) >= nodeHeight(left->rightChild))
+            return makeNode(left->key, left->leftChild, makeNode(key, left->rightChild, right));
+
+        // left right case
+        const AVLNode* pivot = left->rightChild;
+        return makeNode(pivot->key, makeNode(left->key, left->leftChild, pivot->leftChild), makeNode(key, pivot->rightChild, right));
+    }
+    else if (rightHeight > leftHeight + 1)
+    {
+        // right right case
+        if (nodeHeight(right->rightChild) >= nodeHeight(right->leftChild))
+            return makeNode(right->key, makeNode(key, left, right->leftChild), right->rightChild);
+
+        // right left case
+        const AVLNode* pivot = right->leftChild;
+        return makeNode(pivot->key, makeNode(key, left, pivot->leftChild), makeNode(right->key, pivot->rightChild, right->rightChild));
+    }
+
+    return makeNode(key, left, right);
+}
+
+template <typename T, typename Compare>
+const typename PersistentAVLTree<T, Compare>::AVLNode* PersistentAVLTree<T, Compare>::_insert(const T& val, const AVLNode* node)
+{
+    if (!node)
+        return makeNode(val, nullptr, nullptr);
+
+    if (m_less(val, node->key))
+    {
+        auto* left = _insert(val, node->leftChild);
+        return left == node->leftChild ? node : balance(node->key, left, node->rightChild);
+    }
+    else if (m_less(node->key, val))
+    {
+        auto* right = _insert(val, node->rightChild);
+        return right == node->rightChild ? node : balance(node->key, node->leftChild, right);
+    }
+
+    return node;
+}
+
+template <typename T, typename Compare>
+const typename PersistentAVLTree<T, Compare>::AVLNode* PersistentAVLTree<T, Compare>::_remove(const T& val, const AVLNode* node)
+{
+    if (!node)
+        return nullptr;
+
+    if (m_less(val, node->key))
+    {
+        auto* left = _remove(val, node->leftChild);
+        return left == node->leftChild ? node : balance(node->key, left, node->rightChild);
+    }
+    else if (m_less(node->key, val))
+    {
+        auto* right = _remove(val, node->rightChild);
+        return right == node->rightChild ? node : balance(node->key, node->leftChild, right);
+    }
+
+    if (!node->leftChild)
+        return node->rightChild;
+    if (!node->rightChild)
+        return node->leftChild;
+
+    const AVLNode* minNode = node->rightChild;
+    while (minNode->leftChild)
+        minNode = minNode->leftChild;
+
+    return balance(minNode->key, node->leftChild, _removeMin(node->rightChild));
+}
+
+template <typename T, typename Compare>
+const typename PersistentAVLTree<T, Compare>::AVLNode* PersistentAVLTree<T, Compare>::_removeMin(const AVLNode* node)
+{
+    if (!node->leftChild)
+        return node->rightChild;
+
+    return balance(node->key, _removeMin(node->leftChild), node->rightChild);
+}
+
+template <typename T, typename Compare>
+inline int PersistentAVLTree<T, Compare>::nodeHeight(const AVLNode* node)
+{
+    return node ? node->height : -1;
+}
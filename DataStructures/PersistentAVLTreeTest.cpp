@@ -0,0 +1,42 @@
+#include "PersistentAVLTree.h"
+
+#include <iostream>
+
+using namespace std;
+
+template <typename Node>
+void printInorder(const Node* node)
+{
+    if (!node)
+        return;
+
+    printInorder(node->leftChild);
+    cout << node->key << " ";
+    printInorder(node->rightChild);
+}
+
+int main()
+{
+    PersistentAVLTree<int> tree;
+
+    int version = 0;
+    for (int i = 0; i < 8; ++i)
+        version = tree.insert(version, i);
+
+    int removed = tree.remove(version, 3);
+
+    printInorder(tree.root(version));
+    cout << endl;
+    printInorder(tree.root(removed));
+    cout << endl;
+    cout << endl;
+
+    cout << tree.versionCount() << endl;
+    cout << tree.height(version) << endl;
+    cout << tree.find(version, 3) << " " << tree.find(removed, 3) << endl;
+    cout << tree.successor(removed, 2)->key << endl;
+    cout << tree.predecessor(removed, 4)->key << endl;
+    cout << endl;
+
+    return 0;
+}
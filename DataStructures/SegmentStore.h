@@ -0,0 +1,195 @@
+#pragma once
+
+#include "../Point.h"
+#include "../Segment.h"
+
+#include <memory_resource>
+#include <utility>
+#include <vector>
+
+// Segments of a sweep stored column by column. Endpoints are ordered once, on
+// insertion: first() is the lexicographically smaller one. The supporting
+// line is kept as y = slope * x + intercept, so evaluating a segment at the
+// sweep position reads two doubles and does not branch. A segment is
+// identified by its index; vertical segments evaluate to their lower end.
+// The columns are allocated from the given memory resource.
+template <typename T>
+class BasicSegmentStore
+{
+public:
+    explicit BasicSegmentStore(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    explicit BasicSegmentStore(const std::vector<BasicSegment<T>>& segments, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    // Returns the id of the new segment.
+    int add(const BasicPoint<T>& p, const BasicPoint<T>& q);
+
+    void reserve(int n);
+
+    void clear();
+
+    int size() const;
+
+    BasicPoint<T> first(int id) const;
+
+    BasicPoint<T> second(int id) const;
+
+    BasicSegment<T> segment(int id) const;
+
+    bool isVertical(int id) const;
+
+    // y of the supporting line at x
+    double valueAt(int id, double x) const;
+
+    double slope(int id) const;
+
+    // Columns, for scans over all segments.
+    const T* firstX() const;
+    const T* firstY() const;
+    const T* secondX() const;
+    const T* secondY() const;
+
+private:
+    std::pmr::vector<T> m_x1, m_y1;
+    std::pmr::vector<T> m_x2, m_y2;
+
+    std::pmr::vector<double> m_slope;
+    std::pmr::vector<double> m_intercept;
+};
+
+using SegmentStore = BasicSegmentStore<double>;
+
+template <typename T>
+BasicSegmentStore<T>::BasicSegmentStore(std::pmr::memory_resource* resource) :
+    m_x1(resource), m_y1(resource),
+    m_x2(resource), m_y2(resource),
+    m_slope(resource),
+    m_intercept(resource)
+{
+}
+
+template <typename T>
+BasicSegmentStore<T>::BasicSegmentStore(const std::vector<BasicSegment<T>>& segments, std::pmr::memory_resource* resource) :
+    BasicSegmentStore(resource)
+{
+    reserve(segments.size());
+
+    for (const auto& s : segments)
+        add(s.p, s.q);
+}
+
+template <typename T>
+int BasicSegmentStore<T>::add(const BasicPoint<T>& p, const BasicPoint<T>& q)
+{
+    BasicPoint<T> a = p, b = q;
+    if (b.x < a.x || (b.x == a.x && b.y < a.y))
+        std::swap(a, b);
+
+    m_x1.push_back(a.x);
+    m_y1.push_back(a.y);
+    m_x2.push_back(b.x);
+    m_y2.push_back(b.y);
+
+    if (a.x == b.x)
+    {
+        m_slope.push_back(0.);
+        m_intercept.push_back(a.y);
+    }
+    else
+    {
+        double slope = (double(b.y) - a.y) / (double(b.x) - a.x);
+        m_slope.push_back(slope);
+        m_intercept.push_back(a.y - slope * a.x);
+    }
+
+    return size() - 1;
+}
+
+template <typename T>
+void BasicSegmentStore<T>::reserve(int n)
+{
+    for (auto* column : {&m_x1, &m_y1, &m_x2, &m_y2})
+        column->reserve(n);
+
+    m_slope.reserve(n);
+    m_intercept.reserve(n);
+}
+
+template <typename T>
+void BasicSegmentStore<T>::clear()
+{
+    for (auto* column : {&m_x1, &m_y1, &m_x2, &m_y2})
+        column->clear();
+
+    m_slope.clear();
+    m_intercept.clear();
+}
+
+template <typename T>
+int BasicSegmentStore<T>::size() const
+{
+    return m_x1.size();
+}
+
+template <typename T>
+BasicPoint<T> BasicSegmentStore<T>::first(int id) const
+{
+    return {m_x1[id], m_y1[id]};
+}
+
+template <typename T>
+BasicPoint<T> BasicSegmentStore<T>::second(int id) const
+{
+    return {m_x2[id], m_y2[id]};
+}
+
+template <typename T>
+BasicSegment<T> BasicSegmentStore<T>::segment(int id) const
+{
+    BasicSegment<T> s(first(id), second(id));
+    s.id = id;
+
+    return s;
+}
+
+template <typename T>
+bool BasicSegmentStore<T>::isVertical(int id) const
+{
+    return m_x1[id] == m_x2[id];
+}
+
+template <typename T>
+double BasicSegmentStore<T>::valueAt(int id, double x) const
+{
+    return m_slope[id] * x + m_intercept[id];
+}
+
+template <typename T>
+double BasicSegmentStore<T>::slope(int id) const
+{
+    return m_slope[id];
+}
+
+template <typename T>
+const T* BasicSegmentStore<T>::firstX() const
+{
+    return m_x1.data();
+}
+
+template <typename T>
+const T* BasicSegmentStore<T>::firstY() const
+{
+    return m_y1.data();
+}
+
+template <typename T>
+const T* BasicSegmentStore<T>::secondX() const
+{
+    return m_x2.data();
+}
+
+template <typename T>
+const T* BasicSegmentStore<T>::secondY() const
+{
+    return m_y2.data();
+}
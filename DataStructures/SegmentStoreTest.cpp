@@ -0,0 +1,35 @@
+#include "SegmentStore.h"
+
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+int main()
+{
+    vector<Segment> segments = { {{1, 5}, {4, 5}}, {{10, 1}, {2, 5}}, {{3, 2}, {10, 3}}, {{6, 4}, {6, 1}} };
+
+    SegmentStore store(segments);
+
+    for (int id = 0; id < store.size(); ++id)
+        cout << id << ": " << store.first(id) << " -> " << store.second(id) << (store.isVertical(id) ? " vertical" : "") << endl;
+    cout << endl;
+
+    for (double x : {2., 6.})
+    {
+        cout << "x = " << x << ":";
+        for (int id = 0; id < store.size(); ++id)
+            cout << " " << store.valueAt(id, x);
+        cout << endl;
+    }
+    cout << endl;
+
+    BasicSegmentStore<int32_t> grid;
+    grid.add({0, 0}, {-4, 2});
+    grid.add({3, 3}, {3, -3});
+
+    for (int id = 0; id < grid.size(); ++id)
+        cout << id << ": " << grid.first(id) << " -> " << grid.second(id) << endl;
+
+    return 0;
+}
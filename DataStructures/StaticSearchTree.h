@@ -0,0 +1,194 @@
+#pragma once
+
+#include "AVLTree.h"
+
+#include <cstddef>
+#include <vector>
+
+// Read-only ordered set stored as an implicit binary tree in Eytzinger (BFS)
+// order: the children of slot k live at 2k and 2k + 1. Searches descend
+// without data-dependent branches and prefetch the descendants four levels
+// down, so a lookup overlaps its cache misses instead of paying one per
+// level. Queries mirror AVLTree::find/successor/predecessor but return a
+// pointer to the key, nullptr when there is none.
+template <typename T>
+class StaticSearchTree
+{
+public:
+    StaticSearchTree() = default;
+
+    // [first, last) must be strictly increasing.
+    template <typename InputIt>
+    StaticSearchTree(InputIt first, InputIt last);
+
+    bool isEmpty() const;
+
+    int size() const;
+
+    const T* min() const;
+    const T* max() const;
+
+    bool find(const T& val) const;
+
+    // Smallest key not smaller than val.
+    const T* lowerBound(const T& val) const;
+
+    // Largest key smaller than val.
+    const T* predecessor(const T& val) const;
+
+    // Smallest key larger than val.
+    const T* successor(const T& val) const;
+
+private:
+    template <typename InputIt>
+    void fill(std::size_t k, InputIt& it);
+
+    void prefetch(std::size_t k) const;
+
+    const T* at(std::size_t k) const;
+
+private:
+    // Slot 0 is unused so that the root is 1.
+    std::vector<T> m_keys;
+    std::size_t m_size = 0;
+};
+
+// Snapshots the keys of an AVLTree into its read-only counterpart.
+template <typename T, typename Augmentation>
+StaticSearchTree<T> freeze(const AVLTree<T, Augmentation>& tree)
+{
+    return StaticSearchTree<T>(tree.begin(), tree.end());
+}
+
+template <typename T>
+template <typename InputIt>
+StaticSearchTree<T>::StaticSearchTree(InputIt first, InputIt last)
+{
+    std::vector<T> sorted(first, last);
+
+    m_size = sorted.size();
+    m_keys.resize(m_size + 1, sorted.empty() ? T() : sorted.front());
+
+    auto it = sorted.begin();
+    fill(1, it);
+}
+
+template <typename T>
+inline bool StaticSearchTree<T>::isEmpty() const
+{
+    return m_size == 0;
+}
+
+template <typename T>
+inline int StaticSearchTree<T>::size() const
+{
+    return static_cast<int>(m_size);
+}
+
+template <typename T>
+const T* StaticSearchTree<T>::min() const
+{
+    if (isEmpty())
+        return nullptr;
+
+    std::size_t k = 1;
+    while (2 * k <= m_size)
+        k = 2 * k;
+
+    return at(k);
+}
+
+template <typename T>
+const T* StaticSearchTree<T>::max() const
+{
+    if (isEmpty())
+        return nullptr;
+
+    std::size_t k = 1;
+    while (2 * k + 1 <= m_size)
+        k = 2 * k + 1;
+
+    return at(k);
+}
+
+template <typename T>
+bool StaticSearchTree<T>::find(const T& val) const
+{
+    const T* key = lowerBound(val);
+    return key && !(val < *key);
+}
+
+template <typename T>
+const T* StaticSearchTree<T>::lowerBound(const T& val) const
+{
+    std::size_t k = 1;
+    while (k <= m_size)
+    {
+        prefetch(k);
+        k = 2 * k + (m_keys[k] < val);
+    }
+
+    // Drop the trailing right turns and the last left turn: what remains is
+    // the last node where the search went left, i.e. the first key >= val.
+    k >>= __builtin_ctzll(~k) + 1;
+
+    return at(k);
+}
+
+template <typename T>
+const T* StaticSearchTree<T>::predecessor(const T& val) const
+{
+    std::size_t k = 1;
+    while (k <= m_size)
+    {
+        prefetch(k);
+        k = 2 * k + (m_keys[k] < val);
+    }
+
+    // Last node where the search went right.
+    k >>= __builtin_ctzll(k) + 1;
+
+    return at(k);
+}
+
+template <typename T>
+const T* StaticSearchTree<T>::successor(const T& val) const
+{
+    std::size_t k = 1;
+    while (k <= m_size)
+    {
+        prefetch(k);
+        k = 2 * k + !(val < m_keys[k]);
+    }
+
+    k >>= __builtin_ctzll(~k) + 1;
+
+    return at(k);
+}
+
+template <typename T>
+template <typename InputIt>
+void StaticSearchTree<T>::fill(std::size_t k, InputIt& it)
+{
+    if (k > m_size)
+        return;
+
+    fill(2 * k, it);
+    m_keys[k] = *it++;
+    fill(2 * k + 1, it);
+}
+
+template <typename T>
+inline void StaticSearchTree<T>::prefetch(std::size_t k) const
+{
+    // Four levels down, the 16 descendants of k are contiguous.
+    std::size_t descendant = 16 * k;
+    if (descendant <= m_size)
+        __builtin_prefetch(m_keys.data() + descendant);
+}
+
+template <typename T>
+inline const T* StaticSearchTree<T>::at(std::size_t k) const
+{
+    return k ? &m_keys[k] : nullptr;
+}
@@ -0,0 +1,30 @@
+#include "StaticSearchTree.h"
+
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+int main()
+{
+    AVLTree<int> tree;
+    for (int i = 0; i < 10; ++i)
+        tree.insert(2 * i);
+
+    auto frozen = freeze(tree);
+
+    cout << frozen.size() << endl;
+    cout << *frozen.min() << " " << *frozen.max() << endl;
+    cout << frozen.find(6) << " " << frozen.find(7) << endl;
+    cout << *frozen.successor(6) << " " << *frozen.predecessor(6) << endl;
+    cout << *frozen.successor(7) << " " << *frozen.predecessor(7) << endl;
+    cout << *frozen.lowerBound(7) << endl;
+    cout << (frozen.successor(18) == nullptr) << " " << (frozen.predecessor(0) == nullptr) << endl;
+    cout << endl;
+
+    vector<double> sorted = { -1.5, 0.25, 3.75 };
+    StaticSearchTree<double> fromRange(sorted.begin(), sorted.end());
+    cout << *fromRange.successor(0.) << endl;
+
+    return 0;
+}
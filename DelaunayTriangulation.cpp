@@ -0,0 +1,597 @@
+#include "Point.h"
+#include "Util.h"
+
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <cstdint>
+
+#include <gtest/gtest.h>
+
+
+using namespace std;
+
+struct Triangulation
+{
+    // three point indices per triangle, counter-clockwise
+    vector<int> triangles;
+
+    // neighbours[3 * t + i] is the triangle across the edge from vertex i to
+    // vertex i + 1 of triangle t, -1 on the hull
+    vector<int> neighbours;
+
+    // hull vertices in clockwise order, collinear boundary points included
+    vector<int> hull;
+};
+
+double orient2d(const Point& a, const Point& b, const Point& c)
+{
+    return (b - a) ^ (c - a);
+}
+
+// > 0 when d lies strictly inside the circumcircle of the counter-clockwise triangle abc
+double inCircle(const Point& a, const Point& b, const Point& c, const Point& d)
+{
+    double adx = a.x - d.x, ady = a.y - d.y;
+    double bdx = b.x - d.x, bdy = b.y - d.y;
+    double cdx = c.x - d.x, cdy = c.y - d.y;
+
+    return (adx * adx + ady * ady) * (bdx * cdy - cdx * bdy)
+         + (bdx * bdx + bdy * bdy) * (cdx * ady - adx * cdy)
+         + (cdx * cdx + cdy * cdy) * (adx * bdy - bdx * ady);
+}
+
+uint64_t hilbertIndex(uint32_t x, uint32_t y, uint32_t side)
+{
+    uint64_t d = 0;
+
+    for (uint32_t s = side / 2; s > 0; s /= 2)
+    {
+        uint32_t rx = (x & s) > 0;
+        uint32_t ry = (y & s) > 0;
+        d += static_cast<uint64_t>(s) * s * ((3 * rx) ^ ry);
+
+        if (ry == 0)
+        {
+            if (rx == 1)
+            {
+                x = side - 1 - x;
+                y = side - 1 - y;
+            }
+            swap(x, y);
+        }
+    }
+
+    return d;
+}
+
+// Biased randomized insertion order: a random permutation cut into rounds
+// of doubling size, each round sorted along a Hilbert curve. Consecutive
+// insertions are close together, which keeps point location walks short,
+// while the rounds keep the expected work of a random order.
+vector<int> brioOrder(const vector<Point>& points, unsigned seed)
+{
+    const uint32_t side = 1u << 16;
+
+    vector<int> order(points.size());
+    iota(order.begin(), order.end(), 0);
+
+    if (points.empty())
+        return order;
+
+    double minX = points[0].x, maxX = minX, minY = points[0].y, maxY = minY;
+    for (const auto& p : points)
+    {
+        minX = min(minX, p.x);
+        maxX = max(maxX, p.x);
+        minY = min(minY, p.y);
+        maxY = max(maxY, p.y);
+    }
+
+    double scale = (side - 1) / max(max(maxX - minX, maxY - minY), 1e-300);
+
+    vector<uint64_t> keys(points.size());
+    for (int i = 0; i < points.size(); ++i)
+    {
+        auto x = static_cast<uint32_t>((points[i].x - minX) * scale);
+        auto y = static_cast<uint32_t>((points[i].y - minY) * scale);
+        keys[i] = hilbertIndex(x, y, side);
+    }
+
+    shuffle(order.begin(), order.end(), mt19937(seed));
+
+    for (int end = order.size(); end > 0;)
+    {
+        int begin = end < 64 ? 0 : end / 2;
+        sort(order.begin() + begin, order.begin() + end, [&keys](int a, int b) {
+            return keys[a] < keys[b];
+        });
+        end = begin;
+    }
+
+    return order;
+}
+
+// Incremental Bowyer-Watson insertion. The outside of the hull is covered by
+// ghost triangles sharing a virtual vertex, so points outside the current
+// hull need no special case. Triangles live in two flat index arrays and the
+// slots of the triangles removed by an insertion are reused by the new ones.
+class DelaunayBuilder
+{
+public:
+    explicit DelaunayBuilder(const vector<Point>& points);
+
+    void run(Triangulation& out, unsigned seed);
+
+private:
+    bool isGhost(int t) const;
+
+    bool inConflict(int t, const Point& p) const;
+
+    bool ghostConflict(int a, int b, const Point& p) const;
+
+    int locate(const Point& p);
+
+    bool isDuplicate(int t, const Point& p) const;
+
+    void insert(int vertex, int seed);
+
+    void setTriangle(int t, int a, int b, int c);
+
+    int newTriangle();
+
+    void extract(Triangulation& out) const;
+
+private:
+    const vector<Point>& m_points;
+
+    // index of the virtual vertex of the ghost triangles
+    const int m_ghost;
+
+    vector<int> m_vertices;
+    vector<int> m_neighbours;
+
+    // m_mark[t] == m_stamp: t is in the current cavity, -m_stamp: tested and outside
+    vector<int> m_mark;
+    int m_stamp = 0;
+
+    struct BoundaryEdge
+    {
+        int from, to, outside;
+    };
+
+    vector<int> m_stack;
+    vector<int> m_cavity;
+    vector<BoundaryEdge> m_boundary;
+    vector<int> m_newTriangleFrom;
+
+    int m_last = 0;
+    unsigned m_walkRotation = 0;
+};
+
+DelaunayBuilder::DelaunayBuilder(const vector<Point>& points) :
+    m_points(points),
+    m_ghost(points.size()),
+    m_newTriangleFrom(points.size() + 1, -1)
+{
+    m_vertices.reserve(6 * points.size() + 12);
+    m_neighbours.reserve(6 * points.size() + 12);
+    m_mark.reserve(2 * points.size() + 4);
+}
+
+void DelaunayBuilder::run(Triangulation& out, unsigned seed)
+{
+    out.triangles.clear();
+    out.neighbours.clear();
+    out.hull.clear();
+
+    STATS_PHASE("order");
+    auto order = brioOrder(m_points, seed);
+
+    STATS_NEXT_PHASE("insert");
+
+    // seed triangle: the first point, the next distinct one and the next one off their line
+    int i0 = 0, i1 = -1, i2 = -1;
+    for (int i = 1; i < order.size() && i2 < 0; ++i)
+    {
+        const auto& p = m_points[order[i]];
+        if (i1 < 0)
+        {
+            if (p.x != m_points[order[i0]].x || p.y != m_points[order[i0]].y)
+                i1 = i;
+        }
+        else if (orient2d(m_points[order[i0]], m_points[order[i1]], p) != 0.)
+        {
+            i2 = i;
+        }
+    }
+
+    if (i2 < 0)
+    {
+        // fewer than three points in general position: no triangles, the hull
+        // is the segment between the extreme points
+        if (!order.empty())
+        {
+            auto extremes = minmax_element(order.begin(), order.end(), [this](int a, int b) {
+                return lexicographicLess(m_points[a], m_points[b]);
+            });
+
+            out.hull.push_back(*extremes.first);
+            if (i1 >= 0)
+                out.hull.push_back(*extremes.second);
+        }
+        return;
+    }
+
+    int a = order[i0], b = order[i1], c = order[i2];
+    if (orient2d(m_points[a], m_points[b], m_points[c]) < 0.)
+        swap(b, c);
+
+    for (int t = 0; t < 4; ++t)
+        newTriangle();
+
+    setTriangle(0, a, b, c);
+    setTriangle(1, b, a, m_ghost);
+    setTriangle(2, c, b, m_ghost);
+    setTriangle(3, a, c, m_ghost);
+
+    // ghost (x, y, G) borders the ghost starting at y and the one ending at x
+    const int neighbours[4][3] = { {1, 2, 3}, {0, 3, 2}, {0, 1, 3}, {0, 2, 1} };
+    for (int t = 0; t < 4; ++t)
+        for (int e = 0; e < 3; ++e)
+            m_neighbours[3 * t + e] = neighbours[t][e];
+
+    for (int i = 1; i < order.size(); ++i)
+    {
+        if (i == i1 || i == i2)
+            continue;
+
+        const auto& p = m_points[order[i]];
+
+        int t = locate(p);
+        if (isDuplicate(t, p))
+            continue;
+
+        insert(order[i], t);
+    }
+
+    STATS_NEXT_PHASE("output");
+    extract(out);
+}
+
+inline bool DelaunayBuilder::isGhost(int t) const
+{
+    return m_vertices[3 * t] == m_ghost || m_vertices[3 * t + 1] == m_ghost || m_vertices[3 * t + 2] == m_ghost;
+}
+
+bool DelaunayBuilder::inConflict(int t, const Point& p) const
+{
+    int a = m_vertices[3 * t], b = m_vertices[3 * t + 1], c = m_vertices[3 * t + 2];
+
+    if (c == m_ghost)
+        return ghostConflict(a, b, p);
+    if (a == m_ghost)
+        return ghostConflict(b, c, p);
+    if (b == m_ghost)
+        return ghostConflict(c, a, p);
+
+    return inCircle(m_points[a], m_points[b], m_points[c], p) > 0.;
+}
+
+// The "circumcircle" of ghost (a, b, G) is the open half-plane left of a->b
+// plus the open segment ab itself.
+bool DelaunayBuilder::ghostConflict(int a, int b, const Point& p) const
+{
+    const auto& pa = m_points[a];
+    const auto& pb = m_points[b];
+
+    double o = orient2d(pa, pb, p);
+    if (o != 0.)
+        return o > 0.;
+
+    return ((p - pa) & (pb - pa)) > 0. && ((p - pb) & (pa - pb)) > 0.;
+}
+
+// Visibility walk from the last inserted triangle; stops in the triangle
+// containing p or in the ghost triangle of a hull edge that sees p.
+int DelaunayBuilder::locate(const Point& p)
+{
+    int t = m_last;
+
+    while (true)
+    {
+        bool moved = false;
+        unsigned rotation = m_walkRotation++ % 3;
+
+        for (int k = 0; k < 3; ++k)
+        {
+            int e = (k + rotation) % 3;
+            int a = m_vertices[3 * t + e];
+            int b = m_vertices[3 * t + (e + 1) % 3];
+
+            if (orient2d(m_points[a], m_points[b], p) < 0.)
+            {
+                t = m_neighbours[3 * t + e];
+                moved = true;
+                break;
+            }
+        }
+
+        if (!moved || isGhost(t))
+            return t;
+    }
+}
+
+bool DelaunayBuilder::isDuplicate(int t, const Point& p) const
+{
+    for (int e = 0; e < 3; ++e)
+    {
+        int v = m_vertices[3 * t + e];
+        if (v != m_ghost && m_points[v].x == p.x && m_points[v].y == p.y)
+            return true;
+    }
+
+    return false;
+}
+
+void DelaunayBuilder::insert(int vertex, int seed)
+{
+    const auto& p = m_points[vertex];
+
+    ++m_stamp;
+    m_cavity.clear();
+    m_boundary.clear();
+
+    m_mark[seed] = m_stamp;
+    m_stack.push_back(seed);
+
+    while (!m_stack.empty())
+    {
+        int t = m_stack.back();
+        m_stack.pop_back();
+        m_cavity.push_back(t);
+
+        for (int e = 0; e < 3; ++e)
+        {
+            int n = m_neighbours[3 * t + e];
+            if (m_mark[n] == m_stamp)
+                continue;
+
+            if (m_mark[n] != -m_stamp && inConflict(n, p))
+            {
+                m_mark[n] = m_stamp;
+                m_stack.push_back(n);
+            }
+            else
+            {
+                m_mark[n] = -m_stamp;
+                m_boundary.push_back({m_vertices[3 * t + e], m_vertices[3 * t + (e + 1) % 3], n});
+            }
+        }
+    }
+
+    // fan the cavity boundary around the new vertex
+    for (int i = 0; i < m_boundary.size(); ++i)
+    {
+        const auto& edge = m_boundary[i];
+        int t = i < m_cavity.size() ? m_cavity[i] : newTriangle();
+
+        setTriangle(t, edge.from, edge.to, vertex);
+        m_neighbours[3 * t] = edge.outside;
+
+        for (int e = 0; e < 3; ++e)
+        {
+            if (m_vertices[3 * edge.outside + e] == edge.to && m_vertices[3 * edge.outside + (e + 1) % 3] == edge.from)
+            {
+                m_neighbours[3 * edge.outside + e] = t;
+                break;
+            }
+        }
+
+        m_mark[t] = 0;
+        m_newTriangleFrom[edge.from] = t;
+
+        if (edge.from != m_ghost && edge.to != m_ghost)
+            m_last = t;
+    }
+
+    for (const auto& edge : m_boundary)
+    {
+        int t = m_newTriangleFrom[edge.from];
+        int next = m_newTriangleFrom[edge.to];
+
+        m_neighbours[3 * t + 1] = next;
+        m_neighbours[3 * next + 2] = t;
+    }
+
+    for (const auto& edge : m_boundary)
+        m_newTriangleFrom[edge.from] = -1;
+}
+
+inline void DelaunayBuilder::setTriangle(int t, int a, int b, int c)
+{
+    m_vertices[3 * t] = a;
+    m_vertices[3 * t + 1] = b;
+    m_vertices[3 * t + 2] = c;
+}
+
+int DelaunayBuilder::newTriangle()
+{
+    m_vertices.insert(m_vertices.end(), 3, -1);
+    m_neighbours.insert(m_neighbours.end(), 3, -1);
+    m_mark.push_back(0);
+
+    return m_mark.size() - 1;
+}
+
+void DelaunayBuilder::extract(Triangulation& out) const
+{
+    int nTriangles = m_mark.size();
+
+    vector<int> compact(nTriangles, -1);
+    int nReal = 0;
+    for (int t = 0; t < nTriangles; ++t)
+        if (!isGhost(t))
+            compact[t] = nReal++;
+
+    out.triangles.reserve(3 * nReal);
+    out.neighbours.reserve(3 * nReal);
+
+    int ghost = -1;
+    for (int t = 0; t < nTriangles; ++t)
+    {
+        if (compact[t] < 0)
+        {
+            ghost = t;
+            continue;
+        }
+
+        for (int e = 0; e < 3; ++e)
+        {
+            out.triangles.push_back(m_vertices[3 * t + e]);
+            out.neighbours.push_back(compact[m_neighbours[3 * t + e]]);
+        }
+    }
+
+    // walk the ring of ghost triangles: ghost (a, b, G) is followed by the one starting at b
+    int t = ghost;
+    do
+    {
+        int e = 0;
+        while (m_vertices[3 * t + (e + 2) % 3] != m_ghost)
+            ++e;
+
+        out.hull.push_back(m_vertices[3 * t + e]);
+        t = m_neighbours[3 * t + (e + 1) % 3];
+    } while (t != ghost);
+}
+
+// Expected O(n * log(n)), with near-linear behaviour in practice thanks to the
+// spatially coherent insertion order.
+void delaunayTriangulation(const vector<Point>& points, Triangulation& out, unsigned seed = 0)
+{
+    TRACE_SPAN("delaunayTriangulation");
+
+    DelaunayBuilder builder(points);
+    builder.run(out, seed);
+}
+
+
+void checkTriangulation(const vector<Point>& points, const Triangulation& triangulation)
+{
+    const auto& tri = triangulation.triangles;
+    const auto& nb = triangulation.neighbours;
+    int nTriangles = tri.size() / 3;
+
+    for (int t = 0; t < nTriangles; ++t)
+    {
+        const auto& a = points[tri[3 * t]];
+        const auto& b = points[tri[3 * t + 1]];
+        const auto& c = points[tri[3 * t + 2]];
+
+        ASSERT_GT(orient2d(a, b, c), 0.);
+
+        for (int e = 0; e < 3; ++e)
+        {
+            int n = nb[3 * t + e];
+            if (n < 0)
+                continue;
+
+            // the neighbour has the same edge in the opposite direction and points back
+            bool found = false;
+            for (int f = 0; f < 3; ++f)
+            {
+                if (tri[3 * n + f] == tri[3 * t + (e + 1) % 3] && tri[3 * n + (f + 1) % 3] == tri[3 * t + e])
+                {
+                    found = nb[3 * n + f] == t;
+                }
+            }
+            ASSERT_TRUE(found);
+
+            // locally Delaunay: the opposite vertex is not inside the circumcircle
+            int opposite = tri[3 * n] + tri[3 * n + 1] + tri[3 * n + 2] - tri[3 * t + e] - tri[3 * t + (e + 1) % 3];
+            ASSERT_LE(inCircle(a, b, c, points[opposite]), 1e-9);
+        }
+    }
+
+    // the hull is convex, clockwise and contains every point
+    const auto& hull = triangulation.hull;
+    for (int i = 0; i < hull.size(); ++i)
+    {
+        const auto& p = points[hull[i]];
+        const auto& q = points[hull[(i + 1) % hull.size()]];
+        const auto& r = points[hull[(i + 2) % hull.size()]];
+
+        ASSERT_LE(orient2d(p, q, r), 1e-12);
+
+        for (const auto& s : points)
+            ASSERT_LE(orient2d(p, q, s), 1e-9);
+    }
+}
+
+TEST(delaunayTriangulation, simple)
+{
+    vector<Point> input = { {0, 0}, {4, 0}, {4, 4}, {0, 4}, {1, 2} };
+
+    Triangulation triangulation;
+    delaunayTriangulation(input, triangulation);
+
+    EXPECT_EQ(triangulation.triangles.size(), 3 * 4);
+    EXPECT_EQ(triangulation.hull.size(), 4);
+    checkTriangulation(input, triangulation);
+
+    // a point on a hull edge becomes a hull vertex
+    input.push_back({2, 0});
+    delaunayTriangulation(input, triangulation);
+
+    EXPECT_EQ(triangulation.triangles.size(), 3 * 5);
+    EXPECT_EQ(triangulation.hull.size(), 5);
+    checkTriangulation(input, triangulation);
+
+    // duplicates are ignored
+    input.push_back({1, 2});
+    delaunayTriangulation(input, triangulation);
+
+    EXPECT_EQ(triangulation.triangles.size(), 3 * 5);
+    checkTriangulation(input, triangulation);
+
+    vector<Point> collinear = { {0, 0}, {1, 1}, {3, 3}, {2, 2} };
+    delaunayTriangulation(collinear, triangulation);
+
+    EXPECT_TRUE(triangulation.triangles.empty());
+    EXPECT_TRUE((triangulation.hull == vector<int>{0, 2}));
+}
+
+TEST(delaunayTriangulation, random)
+{
+    mt19937 gen(3);
+    uniform_real_distribution<double> coordinate(-1., 1.);
+
+    vector<Point> points(20000);
+    for (auto& p : points)
+        p = {coordinate(gen), coordinate(gen)};
+
+    Triangulation triangulation;
+    delaunayTriangulation(points, triangulation);
+
+    // Euler: 2n - 2 - h triangles for points in general position
+    EXPECT_EQ(triangulation.triangles.size() / 3, 2 * points.size() - 2 - triangulation.hull.size());
+    checkTriangulation(points, triangulation);
+}
+
+TEST(delaunayTriangulation, grid)
+{
+    // many cocircular quadruples
+    vector<Point> points;
+    for (int i = 0; i < 40; ++i)
+        for (int j = 0; j < 40; ++j)
+            points.push_back({double(i), double(j)});
+
+    Triangulation triangulation;
+    delaunayTriangulation(points, triangulation);
+
+    EXPECT_EQ(triangulation.hull.size(), 4 * 39);
+    EXPECT_EQ(triangulation.triangles.size() / 3, 2 * points.size() - 2 - triangulation.hull.size());
+    checkTriangulation(points, triangulation);
+}
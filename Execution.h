@@ -0,0 +1,247 @@
+#pragma once
+
+#include "Stats.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Execution policies of the hull, sort and intersection overloads, after
+// std::execution: seq runs on the calling thread, par on the shared thread
+// pool. par_unseq is taken as par. Whatever the policy and the thread count,
+// an overload gives the output of seq, in the same order.
+struct SequencedPolicy
+{
+};
+
+struct ParallelPolicy
+{
+};
+
+struct ParallelUnsequencedPolicy : ParallelPolicy
+{
+};
+
+inline constexpr SequencedPolicy seq{};
+inline constexpr ParallelPolicy par{};
+inline constexpr ParallelUnsequencedPolicy par_unseq{};
+
+// Fork-join pool: run(n, f) calls f(0) .. f(n - 1) on the workers and the
+// calling thread, and returns when all have returned. Tasks are taken in order
+// from a shared counter, so the thread running a task varies: a task writes
+// its results to its own slot. A run() from inside a task, or while another
+// thread's run() is in flight, calls the tasks in order on the calling thread.
+// The stats counted by the workers are added to the caller's before it returns.
+class ThreadPool
+{
+public:
+    // nThreads counts the calling thread.
+    explicit ThreadPool(int nThreads)
+    {
+        for (int t = 1; t < nThreads; ++t)
+            m_workers.emplace_back([this] { work(); });
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator= (const ThreadPool&) = delete;
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_wake.notify_all();
+
+        for (auto& w : m_workers)
+            w.join();
+    }
+
+    int size() const
+    {
+        return m_workers.size() + 1;
+    }
+
+    template <typename F>
+    void run(int nTasks, const F& f)
+    {
+        if (m_workers.empty() || nTasks <= 1 || inTask() || !m_runMutex.try_lock())
+        {
+            for (int task = 0; task < nTasks; ++task)
+                f(task);
+            return;
+        }
+
+        std::lock_guard<std::mutex> runLock(m_runMutex, std::adopt_lock);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_call = [](const void* context, int task) {
+                (*static_cast<const F*>(context))(task);
+            };
+            m_context = &f;
+            m_nTasks = nTasks;
+            m_next.store(0, std::memory_order_relaxed);
+            m_busy = m_workers.size();
+            ++m_generation;
+        }
+        m_wake.notify_all();
+
+        drain();
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done.wait(lock, [this] { return m_busy == 0; });
+
+#ifdef GEOMETRY_STATS
+        stats().addCounters(m_stats);
+        m_stats = Stats();
+#endif
+    }
+
+private:
+    static bool& inTask()
+    {
+        thread_local bool flag = false;
+        return flag;
+    }
+
+    void drain()
+    {
+        inTask() = true;
+        for (int task; (task = m_next.fetch_add(1, std::memory_order_relaxed)) < m_nTasks;)
+            m_call(m_context, task);
+        inTask() = false;
+    }
+
+    void work()
+    {
+        uint64_t seen = 0;
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_wake.wait(lock, [&] { return m_stop || m_generation != seen; });
+                if (m_stop)
+                    return;
+                seen = m_generation;
+            }
+
+#ifdef GEOMETRY_STATS
+            resetStats();
+#endif
+            drain();
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+#ifdef GEOMETRY_STATS
+            m_stats.addCounters(stats());
+#endif
+            if (--m_busy == 0)
+                m_done.notify_one();
+        }
+    }
+
+private:
+    std::vector<std::thread> m_workers;
+
+    std::mutex m_runMutex;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake, m_done;
+    bool m_stop = false;
+    uint64_t m_generation = 0;
+    int m_busy = 0;
+
+    // the job of the current run()
+    void (*m_call)(const void*, int) = nullptr;
+    const void* m_context = nullptr;
+    int m_nTasks = 0;
+    std::atomic<int> m_next{0};
+
+    // what the workers counted for it
+    Stats m_stats;
+};
+
+struct SharedPool
+{
+    std::mutex mutex;
+    std::unique_ptr<ThreadPool> pool;
+};
+
+inline SharedPool& sharedPool()
+{
+    static SharedPool shared;
+    return shared;
+}
+
+// The pool behind par, started on first use with hardware_concurrency()
+// threads.
+inline ThreadPool& threadPool()
+{
+    auto& shared = sharedPool();
+    std::lock_guard<std::mutex> lock(shared.mutex);
+
+    if (!shared.pool)
+        shared.pool = std::make_unique<ThreadPool>(std::max(1u, std::thread::hardware_concurrency()));
+
+    return *shared.pool;
+}
+
+// Restarts the pool with nThreads threads, counting the calling one; 1 runs
+// par like seq. Not while a parallel call is running.
+inline void setThreadCount(int nThreads)
+{
+    auto& shared = sharedPool();
+    std::lock_guard<std::mutex> lock(shared.mutex);
+
+    shared.pool.reset();
+    shared.pool = std::make_unique<ThreadPool>(std::max(1, nThreads));
+}
+
+// Fewest elements worth a task of their own.
+inline constexpr int ParallelGrain = 1 << 13;
+
+// Bounds of parts ranges of about the same length covering [0, n).
+inline std::vector<int> splitRange(int n, int parts)
+{
+    std::vector<int> bounds(parts + 1);
+    for (int k = 0; k <= parts; ++k)
+        bounds[k] = static_cast<long long>(n) * k / parts;
+
+    return bounds;
+}
+
+// Runs f(first, last, part) on the pool for nParts ranges of [0, n) of about
+// the same length.
+template <typename F>
+void forRanges(size_t n, int nParts, const F& f)
+{
+    threadPool().run(nParts, [&](int part) {
+        f(n * part / nParts, n * (part + 1) / nParts, part);
+    });
+}
+
+// Runs f(firstSet, lastSet) on the pool for nParts runs of point sets of
+// about the same number of points; set i is [offsets[i], offsets[i + 1]).
+template <typename F>
+void forSetRanges(const std::vector<int>& offsets, int nParts, const F& f)
+{
+    int nSets = std::max<int>(0, offsets.size() - 1);
+
+    std::vector<int> firstSets(nParts + 1, nSets);
+    for (int part = 1; part < nParts; ++part)
+    {
+        long long target = offsets[0] + static_cast<long long>(offsets[nSets] - offsets[0]) * part / nParts;
+        firstSets[part] = std::lower_bound(offsets.begin(), offsets.begin() + nSets, target) - offsets.begin();
+    }
+    firstSets[0] = 0;
+
+    threadPool().run(nParts, [&](int part) {
+        f(firstSets[part], firstSets[part + 1]);
+    });
+}
@@ -4,15 +4,18 @@
 
 #include <vector>
 #include <utility>
+#include <random>
+#include <thread>
 
 #include <gtest/gtest.h>
 
 
 using namespace std;
 
-void lineSegmentIntersectionNaive(const vector<Segment>& segments, vector<pair<int, int>>& intersectingSegmentIds, vector<Point>& intersectionPoints)
+template <typename T>
+void lineSegmentIntersectionNaive(const vector<BasicSegment<T>>& segments, vector<pair<int, int>>& intersectingSegmentIds, vector<BasicPoint<T>>& intersectionPoints)
 {
-    Point p;
+    BasicPoint<T> p;
 
     for (int i = 0; i < segments.size(); ++i)
     {        
@@ -27,6 +30,71 @@ void lineSegmentIntersectionNaive(const vector<Segment>& segments, vector<pair<i
     }
 }
 
+template <typename T>
+void lineSegmentIntersectionNaive(const SequencedPolicy&, const vector<BasicSegment<T>>& segments, vector<pair<int, int>>& intersectingSegmentIds, vector<BasicPoint<T>>& intersectionPoints)
+{
+    lineSegmentIntersectionNaive(segments, intersectingSegmentIds, intersectionPoints);
+}
+
+// The rows i of the pair loop are cut into tasks of about the same number of
+// pairs. Every task collects its crossings, which are appended in task order:
+// the output is the sequential one.
+template <typename T>
+void lineSegmentIntersectionNaive(const ParallelPolicy&, const vector<BasicSegment<T>>& segments, vector<pair<int, int>>& intersectingSegmentIds, vector<BasicPoint<T>>& intersectionPoints)
+{
+    TRACE_SPAN("lineSegmentIntersectionNaive");
+
+    auto& pool = threadPool();
+
+    int n = segments.size();
+    long long pairs = static_cast<long long>(n) * (n - 1) / 2;
+
+    int nTasks = static_cast<int>(min<long long>(4 * pool.size(), pairs / ParallelGrain));
+    if (pool.size() == 1 || nTasks < 2)
+    {
+        lineSegmentIntersectionNaive(segments, intersectingSegmentIds, intersectionPoints);
+        return;
+    }
+
+    // row i holds n - 1 - i pairs
+    vector<int> firstRows(nTasks + 1, n);
+    firstRows[0] = 0;
+
+    long long before = 0;
+    for (int i = 0, t = 1; i < n && t < nTasks; ++i)
+    {
+        before += n - 1 - i;
+        while (t < nTasks && before >= pairs * t / nTasks)
+            firstRows[t++] = i + 1;
+    }
+
+    vector<vector<pair<int, int>>> ids(nTasks);
+    vector<vector<BasicPoint<T>>> points(nTasks);
+
+    pool.run(nTasks, [&](int t) {
+        TRACE_SPAN("rows");
+
+        BasicPoint<T> p;
+        for (int i = firstRows[t]; i < firstRows[t + 1]; ++i)
+        {
+            for (int j = i + 1; j < n; ++j)
+            {
+                if (intersection(segments[i], segments[j], p))
+                {
+                    ids[t].push_back(make_pair(i, j));
+                    points[t].push_back(p);
+                }
+            }
+        }
+    });
+
+    for (int t = 0; t < nTasks; ++t)
+    {
+        intersectingSegmentIds.insert(intersectingSegmentIds.end(), ids[t].begin(), ids[t].end());
+        intersectionPoints.insert(intersectionPoints.end(), points[t].begin(), points[t].end());
+    }
+}
+
 
 TEST(lineSegmentIntersectionNaive, simple)
 {
@@ -59,9 +127,69 @@ TEST(lineSegmentIntersectionNaive, simple)
     intersectingSegmentIdsOut.clear();
     lineSegmentIntersectionNaive(segments, intersectingSegmentIdsOut, intersectionsOut);
 
-    intersectionsExpected = {{2, 5}, {6.8889, 2.5556}};
+    intersectionsExpected = {{2, 5}, {62. / 9, 23. / 9}};
     intersectingSegmentIdsExpected = {{0, 1}, {1, 2}};
 
     EXPECT_TRUE(intersectingSegmentIdsExpected == intersectingSegmentIdsOut);
     EXPECT_TRUE(intersectionsExpected == intersectionsOut);
 }
+
+TEST(lineSegmentIntersectionNaive, integer)
+{
+    using SegmentI = BasicSegment<int64_t>;
+
+    vector<SegmentI> segments = { {{0, 0}, {4, 4}}, {{4, 0}, {0, 4}}, {{4, 4}, {9, 4}}, {{0, 2}, {4, 6}} };
+    vector<pair<int, int>> intersectingSegmentIdsOut;
+    vector<BasicPoint<int64_t>> intersectionsOut;
+
+    lineSegmentIntersectionNaive(segments, intersectingSegmentIdsOut, intersectionsOut);
+
+    // touching at an endpoint counts, parallel segments do not
+    vector<pair<int, int>> intersectingSegmentIdsExpected = {{0, 1}, {0, 2}, {1, 3}};
+    vector<BasicPoint<int64_t>> intersectionsExpected = { {2, 2}, {4, 4}, {1, 3} };
+
+    EXPECT_TRUE(intersectingSegmentIdsExpected == intersectingSegmentIdsOut);
+    EXPECT_TRUE(intersectionsExpected == intersectionsOut);
+}
+
+TEST(lineSegmentIntersectionNaive, policies)
+{
+    mt19937 gen(101);
+    uniform_real_distribution<double> coordinate(0., 100.);
+    uniform_real_distribution<double> offset(-10., 10.);
+
+    vector<Segment> segments;
+    for (int i = 0; i < 600; ++i)
+    {
+        Point p{coordinate(gen), coordinate(gen)};
+        segments.push_back({p, {p.x + offset(gen), p.y + offset(gen)}});
+    }
+
+    vector<pair<int, int>> expectedIds;
+    vector<Point> expectedPoints;
+    lineSegmentIntersectionNaive(seq, segments, expectedIds, expectedPoints);
+    ASSERT_FALSE(expectedIds.empty());
+
+    for (int nThreads : {1, 3, 4})
+    {
+        setThreadCount(nThreads);
+
+        vector<pair<int, int>> ids, unseqIds;
+        vector<Point> points, unseqPoints;
+        resetStats();
+        lineSegmentIntersectionNaive(par, segments, ids, points);
+        lineSegmentIntersectionNaive(par_unseq, segments, unseqIds, unseqPoints);
+
+#ifdef GEOMETRY_STATS
+        // every pair twice, including the rows tested on the workers
+        EXPECT_EQ(stats().intersectionCalls, 600 * 599);
+#endif
+
+        EXPECT_TRUE(ids == expectedIds);
+        EXPECT_TRUE(unseqIds == expectedIds);
+
+        EXPECT_TRUE(equal(points.begin(), points.end(), expectedPoints.begin(), expectedPoints.end(), samePoint<double>));
+    }
+
+    setThreadCount(thread::hardware_concurrency());
+}
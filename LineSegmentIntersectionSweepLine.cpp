@@ -1,209 +1,471 @@
 #include "DataStructures/AVLTree.h"
+#include "DataStructures/SegmentStore.h"
 #include "Point.h"
 #include "Segment.h"
 #include "Util.h"
+#include "Workspace.h"
+#include "AllocationCounter.h"
 
 #include <vector>
 #include <queue>
 #include <utility>
 #include <set>
+#include <unordered_set>
+#include <array>
+#include <numeric>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <cmath>
+#include <random>
+#include <sstream>
+#include <memory_resource>
+#include <thread>
 
 #include <gtest/gtest.h>
 
 
 using namespace std;
 
+// Events at the same position are handled in this order: a segment starts
+// into a status already swapped at the crossings there, so where it goes does
+// not depend on the shape of the tree, and a segment ending at a crossing is
+// still in the status when the crossing is handled.
 enum EventType
 {
+    CROSS,
     START,
-    END,
-    CROSS
+    END
 };
 
+// 16 bytes: the sweep position, then the type and both segment ids packed in
+// one word (31 bits per id). A crossing has the lower segment as id1. Events
+// at the same position and of the same type are ordered by ids, so crossings
+// are handled in the same order whatever else is in the heap.
 struct Event
 {
-    EventType type;
-    Point p;
-    int id1;
-    int id2;
-
     double value;
+    uint64_t packed;
 
     Event() = default;
 
-    Event(EventType type_, const Point& p_, int id1_, int id2_) :
-        type(type_), p(p_), id1(id1_), id2(id2_), value(p.x)
+    Event(EventType type_, double value_, int id1_, int id2_) :
+        value(value_), packed(uint64_t(type_) | uint64_t(id1_) << 2 | uint64_t(id2_) << 33)
+    {
+    }
+
+    EventType type() const
     {
+        return EventType(packed & 3);
+    }
+
+    int id1() const
+    {
+        return int(packed >> 2 & 0x7fffffff);
+    }
+
+    int id2() const
+    {
+        return int(packed >> 33);
     }
 
     bool operator< (const Event& e) const
     {
-        return value < e.value;
+        if (value != e.value)
+            return value < e.value;
+        if (type() != e.type())
+            return type() < e.type();
+
+        return packed < e.packed;
     }
 
     bool operator> (const Event& e) const
     {
-        return value > e.value;
+        return e < *this;
     }
 
     bool operator== (const Event& e) const
     {
-        return value == e.value;
+        return value == e.value && packed == e.packed;
     }
 };
 
-void checkForIntersection(const Segment& s1, const Segment& s2, Point& i, AVLTree<Event>& eventQueue)
+using CrossingQueue = priority_queue<Event, pmr::vector<Event>, greater<Event>>;
+
+// Unsigned key with the same order as x.
+uint64_t orderKey(double x)
 {
-    if (intersection(s1, s2, i))
-        eventQueue.insert(Event{CROSS, i, s1.id, s2.id});
+    x += 0.; // -0 sorts with +0
+
+    uint64_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+
+    return (bits >> 63) ? ~bits : bits | uint64_t(1) << 63;
 }
 
-void removeFuture(const Segment& s1, const Segment& s2, AVLTree<Event>& eventQueue)
+// All START and END events, known up front, sorted once with a stable LSD
+// radix sort on the bytes of x. Starts are generated first so they stay ahead
+// of ends at the same x; bytes shared by all keys are skipped.
+template <typename T>
+pmr::vector<Event> endpointEvents(const BasicSegmentStore<T>& store, pmr::memory_resource* resource)
 {
-    auto* it = eventQueue.min();
+    int n = store.size();
+
+    pmr::vector<Event> events(resource), buffer(2 * n, resource);
+    events.reserve(2 * n);
+
+    for (int i = 0; i < n; ++i)
+        events.emplace_back(START, double(store.firstX()[i]), i, i);
+    for (int i = 0; i < n; ++i)
+        events.emplace_back(END, double(store.secondX()[i]), i, i);
 
-    while (it)
+    array<array<int, 257>, 8> counts = {};
+
+    for (const auto& e : events)
     {
-        const auto& event = it->key;
+        uint64_t key = orderKey(e.value);
+        for (int b = 0; b < 8; ++b)
+            ++counts[b][(key >> 8 * b & 255) + 1];
+    }
 
-        if (event.type == CROSS)
-        {
-            if ((s1.id == event.id1 && s2.id == event.id2) || (s1.id == event.id2 && s2.id == event.id1))
-            {
-                eventQueue.remove(event);
-                return;
-            }
-        }
-    
-        it = eventQueue.successor(event);
+    for (int b = 0; b < 8; ++b)
+    {
+        auto& count = counts[b];
+        if (*max_element(count.begin(), count.end()) == events.size())
+            continue;
+
+        partial_sum(count.begin(), count.end(), count.begin());
+        for (const auto& e : events)
+            buffer[count[orderKey(e.value) >> 8 * b & 255]++] = e;
+
+        events.swap(buffer);
     }
+
+    return events;
 }
 
-void recalculate(double l, AVLTree<Segment>& segmentTree)
+// Orders segment ids by height at the sweep position. Segments meeting there
+// are ordered as they are just right of it, by slope.
+template <typename T>
+struct SegmentBelow
 {
-    auto* it = segmentTree.min();
-    while (it)
+    const BasicSegmentStore<T>* store;
+    const double* x;
+
+    bool operator() (int a, int b) const
     {
-        auto& seg = it->key;
-        seg.calculateValue(l);
-        it = segmentTree.successor(seg);
+        double ya = store->valueAt(a, *x);
+        double yb = store->valueAt(b, *x);
+
+        if (abs(ya - yb) > 1e-9 * (1. + abs(ya) + abs(yb)))
+            return ya < yb;
+
+        if (store->slope(a) != store->slope(b))
+            return store->slope(a) < store->slope(b);
+
+        return a < b;
     }
+};
+
+// below and above are neighbours in the status. A crossing behind the sweep
+// can only be one not handled yet, so it is handled right away.
+template <typename T>
+void checkForIntersection(const BasicSegment<T>& below, const BasicSegment<T>& above, double l, CrossingQueue& crossings)
+{
+    BasicPoint<T> i;
+    if (intersection(below, above, i))
+        crossings.push(Event{CROSS, max(double(i.x), l), below.id, above.id});
 }
 
-void swapSegments(Segment segment1, Segment segment2, AVLTree<Segment>& segmentTree)
+// Endpoint events come from a presorted array; the heap only ever holds
+// crossings. Crossings are not removed when their segments stop being
+// neighbours: a popped crossing is dropped unless they still are, and it is
+// found again if they become neighbours again before it. Every pair that
+// becomes neighbours is checked, so what is handled only depends on the
+// status, not on the stale crossings in the heap.
+//
+// The sweep runs over [xBegin, xEnd]: the segments over xBegin enter the
+// status there at once and the sweep stops after the events at xEnd. Neither
+// bound may be the x of an endpoint; the status at xBegin is then the one the
+// full sweep has after the events there. Crossings handled at xBegin were
+// handled left of it and are not reported. Crossings at or left of xBegin that
+// only turn up later are reported with behind set, as the full sweep may have
+// had them already. The segments have their index as id, endpoints are the
+// events of store. All scratch memory comes from resource; results are
+// appended.
+template <typename T>
+void sweep(const vector<BasicSegment<T>>& segments, const BasicSegmentStore<T>& store, const pmr::vector<Event>& endpoints, double xBegin, double xEnd,
+    vector<pair<int, int>>& intersectingSegmentIds, vector<BasicPoint<T>>& intersectionPoints, vector<char>* behind, pmr::memory_resource* resource)
 {
-    segmentTree.remove(segment1);
-    segmentTree.remove(segment2);
+    CrossingQueue crossings{greater<Event>(), pmr::vector<Event>(resource)};
 
-    double val = segment1.value;
-    segment1.value = segment2.value;
-    segment2.value = val;
+    double l = xBegin;
 
-    segmentTree.insert(segment1);
-    segmentTree.insert(segment2);
-}
+    using Status = pmr::set<int, SegmentBelow<T>>;
+    Status status(SegmentBelow<T>{&store, &l}, resource);
 
-void lineSegmentIntersectionSweepLine(vector<Segment>& segments, vector<pair<int, int>>& intersectingSegmentIds, vector<Point>& intersectionPoints)
-{
-    for (int i = 0; i < segments.size(); ++i)
-        segments[i].id = i;
+    pmr::vector<typename Status::iterator> position(store.size(), resource);
+    pmr::vector<bool> inStatus(store.size(), false, resource);
 
-    AVLTree<Event> eventQueue;
-    AVLTree<Segment> segmentTree;
+    pmr::unordered_set<uint64_t> reported(resource);
 
-    for (int i = 0; i < segments.size(); ++i)
+    auto check = [&](typename Status::iterator below, typename Status::iterator above) {
+        if (below != status.end() && above != status.end())
+            checkForIntersection(segments[*below], segments[*above], l, crossings);
+    };
+
+    auto predecessor = [&](typename Status::iterator it) {
+        return it == status.begin() ? status.end() : prev(it);
+    };
+
+    for (int id = 0; id < store.size(); ++id)
     {
-        eventQueue.insert(Event{START, segments[i].first(), segments[i].id, segments[i].id});
-        eventQueue.insert(Event{END, segments[i].second(), segments[i].id, segments[i].id});
+        if (store.firstX()[id] < xBegin && store.secondX()[id] >= xBegin)
+        {
+            position[id] = status.insert(id).first;
+            inStatus[id] = true;
+        }
     }
 
-    while(!eventQueue.isEmpty())
-    {
-        auto* eventNode = eventQueue.removeMin();
-        Point intersectionPoint;
+    for (auto it = status.begin(); it != status.end(); ++it)
+        check(it, next(it));
 
-        auto event = eventNode->key;
-        double l = event.value;
+    int nextEndpoint = partition_point(endpoints.begin(), endpoints.end(), [&](const Event& e) {
+        return e.value < xBegin;
+    }) - endpoints.begin();
 
-        if (event.type == START)
+    while (nextEndpoint < endpoints.size() || !crossings.empty())
+    {
+        Event event;
+        if (crossings.empty() || (nextEndpoint < endpoints.size() && endpoints[nextEndpoint] < crossings.top()))
         {
-            const auto& segment = segments[event.id1];
-            const auto* successor = segmentTree.successor(segment);
-            const auto* predecessor = segmentTree.predecessor(segment);
+            event = endpoints[nextEndpoint++];
+        }
+        else
+        {
+            event = crossings.top();
+            crossings.pop();
+        }
 
-            recalculate(l, segmentTree);
-            
-            segmentTree.insert(segment);
+        if (event.value > xEnd)
+            break;
 
-            if (successor)
-                checkForIntersection(segment, successor->key, intersectionPoint, eventQueue);
+        if (event.type() == START)
+        {
+            STATS_COUNT(startEvents);
+            l = event.value;
 
-            if (predecessor)
-                checkForIntersection(predecessor->key, segment, intersectionPoint, eventQueue);
+            int id = event.id1();
+            auto it = status.insert(id).first;
+            position[id] = it;
+            inStatus[id] = true;
 
-            if (predecessor && successor)
-                removeFuture(predecessor->key, successor->key, eventQueue);
+            check(predecessor(it), it);
+            check(it, next(it));
         }
-        else if (event.type == END)
+        else if (event.type() == END)
         {
-            const auto& segment = segments[event.id1];
-            const auto* successor = segmentTree.successor(segment);
-            const auto* predecessor = segmentTree.predecessor(segment);
-            
-            if (predecessor && successor)
-                checkForIntersection(predecessor->key, successor->key, intersectionPoint, eventQueue);
-
-            segmentTree.remove(segment);
+            STATS_COUNT(endEvents);
+            l = event.value;
+
+            int id = event.id1();
+            auto it = position[id];
+
+            check(predecessor(it), next(it));
+
+            status.erase(it);
+            inStatus[id] = false;
         }
-        else if (event.type == CROSS)
+        else if (event.type() == CROSS)
         {
-            auto& segment1 = segments[event.id1];
-            auto& segment2 = segments[event.id2];
-
-            intersection(segment1, segment2, intersectionPoint);
-            intersectionPoints.push_back(intersectionPoint);
-            intersectingSegmentIds.push_back({segment1.id, segment2.id});
+            int below = event.id1();
+            int above = event.id2();
 
-            swapSegments(segment1, segment2, segmentTree);
+            uint64_t key = uint64_t(min(below, above)) << 32 | max(below, above);
+            if (!inStatus[below] || !inStatus[above] || next(position[below]) != position[above] || !reported.insert(key).second)
+            {
+                STATS_COUNT(staleEvents);
+                continue;
+            }
 
-            const auto* segment1Successor = segmentTree.successor(segment1);
-            const auto* segment1Predecessor = segmentTree.predecessor(segment1);
+            STATS_COUNT(crossEvents);
 
-            const auto* segment2Successor = segmentTree.successor(segment2);
-            const auto* segment2Predecessor = segmentTree.predecessor(segment2);
-            
-            if (segment1.value < segment2.value)
+            BasicPoint<T> intersectionPoint;
+            intersection(segments[below], segments[above], intersectionPoint);
+            if (event.value > xBegin)
             {
-                if (segment1Successor)
-                {
-                    checkForIntersection(segment1, segment1Successor->key, intersectionPoint, eventQueue);
-                    removeFuture(segment1Successor->key, segment2, eventQueue);
-                }
-
-                if (segment2Predecessor)
-                {
-                    checkForIntersection(segment2Predecessor->key, segment2, intersectionPoint, eventQueue);
-                    removeFuture(segment2Predecessor->key, segment1, eventQueue);
-                }
+                intersectionPoints.push_back(intersectionPoint);
+                intersectingSegmentIds.push_back({min(below, above), max(below, above)});
+                if (behind)
+                    behind->push_back(intersectionPoint.x <= xBegin);
             }
-            else
+
+            // the two are neighbours, so swapping their ids in place swaps
+            // them in the status without comparing to the others; a search
+            // could meet other segments through the crossing still in their
+            // order left of it. Touching ones may already be in order.
+            l = event.value;
+            if (status.key_comp()(above, below))
             {
-                if (segment1Predecessor)
-                {
-                    checkForIntersection(segment1Predecessor->key, segment1, intersectionPoint, eventQueue);
-                    removeFuture(segment1Predecessor->key, segment2, eventQueue);
-                }
-
-                if (segment2Successor)
-                {
-                    checkForIntersection(segment2, segment2Successor->key, intersectionPoint, eventQueue);
-                    removeFuture(segment2Successor->key, segment1, eventQueue);
-                }
+                const_cast<int&>(*position[below]) = above;
+                const_cast<int&>(*position[above]) = below;
+                swap(position[below], position[above]);
+
+                check(predecessor(position[above]), position[above]);
+                check(position[below], next(position[below]));
             }
         }
     }
 }
 
+// All scratch memory comes from resource; results are appended.
+template <typename T>
+void lineSegmentIntersectionSweepLine(vector<BasicSegment<T>>& segments, vector<pair<int, int>>& intersectingSegmentIds, vector<BasicPoint<T>>& intersectionPoints, pmr::memory_resource* resource)
+{
+    TRACE_SPAN("lineSegmentIntersectionSweepLine");
+
+    for (int i = 0; i < segments.size(); ++i)
+        segments[i].id = i;
+
+    STATS_PHASE("events");
+    BasicSegmentStore<T> store(segments, resource);
+    auto endpoints = endpointEvents(store, resource);
+
+    STATS_NEXT_PHASE("sweep");
+    sweep(segments, store, endpoints, -INFINITY, INFINITY, intersectingSegmentIds, intersectionPoints, nullptr, resource);
+}
+
+template <typename T>
+void lineSegmentIntersectionSweepLine(vector<BasicSegment<T>>& segments, vector<pair<int, int>>& intersectingSegmentIds, vector<BasicPoint<T>>& intersectionPoints)
+{
+    lineSegmentIntersectionSweepLine(segments, intersectingSegmentIds, intersectionPoints, pmr::get_default_resource());
+}
+
+// Without heap allocations once the workspace has seen an input of this size
+// and the output vectors have the capacity.
+template <typename T>
+void lineSegmentIntersectionSweepLine(vector<BasicSegment<T>>& segments, vector<pair<int, int>>& intersectingSegmentIds, vector<BasicPoint<T>>& intersectionPoints, Workspace& workspace)
+{
+    lineSegmentIntersectionSweepLine(segments, intersectingSegmentIds, intersectionPoints, workspace.resource());
+}
+
+// Puts the crossings from first on in the order of the policy overloads: by
+// x, then by ids. The plain sweep only orders them by x.
+template <typename T>
+void sortCrossings(int first, vector<pair<int, int>>& intersectingSegmentIds, vector<BasicPoint<T>>& intersectionPoints)
+{
+    vector<int> order(intersectingSegmentIds.size() - first);
+    iota(order.begin(), order.end(), first);
+
+    sort(order.begin(), order.end(), [&](int a, int b) {
+        const auto& p = intersectionPoints[a];
+        const auto& q = intersectionPoints[b];
+        return p.x < q.x || (p.x == q.x && intersectingSegmentIds[a] < intersectingSegmentIds[b]);
+    });
+
+    vector<pair<int, int>> ids(order.size());
+    vector<BasicPoint<T>> points(order.size());
+    for (int k = 0; k < order.size(); ++k)
+    {
+        ids[k] = intersectingSegmentIds[order[k]];
+        points[k] = intersectionPoints[order[k]];
+    }
+
+    copy(ids.begin(), ids.end(), intersectingSegmentIds.begin() + first);
+    copy(points.begin(), points.end(), intersectionPoints.begin() + first);
+}
+
+template <typename T>
+void lineSegmentIntersectionSweepLine(const SequencedPolicy&, vector<BasicSegment<T>>& segments, vector<pair<int, int>>& intersectingSegmentIds, vector<BasicPoint<T>>& intersectionPoints)
+{
+    int first = intersectingSegmentIds.size();
+    lineSegmentIntersectionSweepLine(segments, intersectingSegmentIds, intersectionPoints);
+
+    sortCrossings(first, intersectingSegmentIds, intersectionPoints);
+}
+
+// Vertical slabs holding about the same number of endpoints are swept on the
+// pool, each from the segments over its left side; the store and the sorted
+// endpoint events are shared. A bound lies halfway between two endpoint x, so
+// a slab starts from the status the full sweep has there and handles the same
+// crossings after it. A crossing left of its slab that the full sweep handles
+// late is only kept if no slab before found it. Ties in x are found in an
+// order that depends on the slabs, hence the order by ids.
+template <typename T>
+void lineSegmentIntersectionSweepLine(const ParallelPolicy&, vector<BasicSegment<T>>& segments, vector<pair<int, int>>& intersectingSegmentIds, vector<BasicPoint<T>>& intersectionPoints)
+{
+    auto& pool = threadPool();
+
+    int nSlabs = min<int>(pool.size(), segments.size() / ParallelGrain);
+    if (nSlabs < 2)
+    {
+        lineSegmentIntersectionSweepLine(seq, segments, intersectingSegmentIds, intersectionPoints);
+        return;
+    }
+
+    TRACE_SPAN("lineSegmentIntersectionSweepLine");
+    STATS_PHASE("events");
+
+    for (int i = 0; i < segments.size(); ++i)
+        segments[i].id = i;
+
+    auto* resource = pmr::get_default_resource();
+
+    BasicSegmentStore<T> store(segments, resource);
+    auto endpoints = endpointEvents(store, resource);
+
+    vector<double> bounds = {-INFINITY};
+    for (int k = 1; k < nSlabs; ++k)
+    {
+        auto left = endpoints.begin() + static_cast<long long>(endpoints.size()) * k / nSlabs;
+        auto right = upper_bound(left, endpoints.end(), *left, [](const Event& a, const Event& b) {
+            return a.value < b.value;
+        });
+        if (right == endpoints.end())
+            break;
+
+        double x = left->value + (right->value - left->value) / 2;
+        if (x > left->value && x < right->value && x > bounds.back())
+            bounds.push_back(x);
+    }
+    bounds.push_back(INFINITY);
+    nSlabs = bounds.size() - 1;
+
+    STATS_NEXT_PHASE("sweep");
+    vector<vector<pair<int, int>>> ids(nSlabs);
+    vector<vector<BasicPoint<T>>> points(nSlabs);
+    vector<vector<char>> behind(nSlabs);
+
+    pool.run(nSlabs, [&](int k) {
+        TRACE_SPAN("slab");
+        sweep(segments, store, endpoints, bounds[k], bounds[k + 1], ids[k], points[k], &behind[k], resource);
+    });
+
+    STATS_NEXT_PHASE("output");
+    unordered_set<uint64_t> late;
+    for (int k = 0; k < nSlabs; ++k)
+        for (int j = 0; j < ids[k].size(); ++j)
+            if (behind[k][j])
+                late.insert(uint64_t(ids[k][j].first) << 32 | ids[k][j].second);
+
+    int first = intersectingSegmentIds.size();
+    unordered_set<uint64_t> found;
+    for (int k = 0; k < nSlabs; ++k)
+    {
+        for (int j = 0; j < ids[k].size(); ++j)
+        {
+            uint64_t key = uint64_t(ids[k][j].first) << 32 | ids[k][j].second;
+            if (late.count(key) && !found.insert(key).second)
+                continue;
+
+            intersectingSegmentIds.push_back(ids[k][j]);
+            intersectionPoints.push_back(points[k][j]);
+        }
+    }
+
+    sortCrossings(first, intersectingSegmentIds, intersectionPoints);
+}
+
 TEST(lineSegmentIntersectionSweepLine, simple)
 {
     Point iHat{1, 0};
@@ -253,17 +515,234 @@ TEST(lineSegmentIntersectionSweepLine, simple)
     for (auto i : intersectionsOut)
         cout << i.x << " " << i.y << endl;
 
-    intersectionsExpected = {{2, 5}, {6.8889, 2.5556}};
+    intersectionsExpected = {{2, 5}, {62. / 9, 23. / 9}};
     intersectingSegmentIdsExpected = {{0, 1}, {1, 2}};
 
     EXPECT_TRUE(intersectionsExpected == intersectionsOut);
 
     AVLTree<Event> eventTree;
-    eventTree.insert(Event{START, {1., 2}, 0, 1});
-    eventTree.insert(Event{END, {1., 2}, 1, 1});
-    eventTree.insert(Event{START, {1., -1}, 2, 2});
-    eventTree.insert(Event{END, {1., -1}, 3, 2});
-    eventTree.insert(Event{START, {-1., 2}, 4, 3});
+    eventTree.insert(Event{START, 1., 0, 1});
+    eventTree.insert(Event{END, 1., 1, 1});
+    eventTree.insert(Event{START, 1., 2, 2});
+    eventTree.insert(Event{END, 1., 3, 2});
+    eventTree.insert(Event{START, -1., 4, 3});
+
+    Event event;
+    EXPECT_TRUE(eventTree.removeMin(event));
+    EXPECT_EQ(event.value, -1.);
+}
+
+TEST(lineSegmentIntersectionSweepLine, random)
+{
+    mt19937 gen(31);
+    uniform_real_distribution<double> coordinate(0., 100.);
+    uniform_real_distribution<double> offset(-8., 8.);
+
+    for (int n : {2, 10, 100, 2000})
+    {
+        vector<Segment> segments;
+        for (int i = 0; i < n; ++i)
+        {
+            Point p{coordinate(gen), coordinate(gen)};
+            segments.push_back({p, {p.x + offset(gen), p.y + offset(gen)}});
+        }
+
+        vector<pair<int, int>> expected;
+        Point i;
+        for (int a = 0; a < n; ++a)
+            for (int b = a + 1; b < n; ++b)
+                if (intersection(segments[a], segments[b], i))
+                    expected.push_back({a, b});
+
+        vector<pair<int, int>> ids;
+        vector<Point> points;
+        lineSegmentIntersectionSweepLine(segments, ids, points);
+
+        ASSERT_EQ(ids.size(), points.size());
+        for (int k = 1; k < points.size(); ++k)
+            ASSERT_LE(points[k - 1].x, points[k].x + 1e-9);
+
+        sort(ids.begin(), ids.end());
+        EXPECT_TRUE(ids == expected);
+    }
+}
+
+TEST(lineSegmentIntersectionSweepLine, stats)
+{
+    vector<Segment> segments = { { {0, 0}, {1, 1} }, { {1, 0}, {0, 1} }, { {2, 0}, {3, 0} } };
+
+    vector<pair<int, int>> ids;
+    vector<Point> points;
+
+    resetStats();
+    int64_t begin = traceNow();
+    lineSegmentIntersectionSweepLine(segments, ids, points);
+    int64_t end = traceNow();
+
+    const auto& s = stats();
+
+#ifdef GEOMETRY_STATS
+    EXPECT_EQ(s.startEvents, 3);
+    EXPECT_EQ(s.endEvents, 3);
+    EXPECT_EQ(s.crossEvents, 1);
+    EXPECT_GT(s.intersectionCalls, 0);
+    EXPECT_EQ(s.phases.size(), 2);
+#else
+    EXPECT_EQ(s.startEvents, 0);
+    EXPECT_TRUE(s.phases.empty());
+#endif
+
+    // the phases do not overlap
+    double seconds = 0.;
+    for (const auto& phase : s.phases)
+        seconds += phase.second;
+    EXPECT_LE(seconds, (end - begin) * 1e-9);
+
+    ostringstream json;
+    s.writeJson(json);
+    EXPECT_NE(json.str().find("\"crossEvents\": "), string::npos);
+
+    // enough for slabs: the workers' events count too
+    mt19937 gen(107);
+    uniform_real_distribution<double> coordinate(0., 1000.);
+
+    int n = 3 * ParallelGrain;
+
+    segments.clear();
+    for (int i = 0; i < n; ++i)
+    {
+        Point p{coordinate(gen), coordinate(gen)};
+        segments.push_back({p, {p.x + 1., p.y + 1.}});
+    }
+
+    setThreadCount(3);
+    resetStats();
+    lineSegmentIntersectionSweepLine(par, segments, ids, points);
+
+#ifdef GEOMETRY_STATS
+    EXPECT_EQ(stats().startEvents, n);
+    EXPECT_EQ(stats().endEvents, n);
+#endif
+
+    setThreadCount(thread::hardware_concurrency());
+}
+
+TEST(lineSegmentIntersectionSweepLine, workspace)
+{
+    mt19937 gen(73);
+    uniform_real_distribution<double> coordinate(0., 100.);
+    uniform_real_distribution<double> offset(-8., 8.);
+
+    // alternating input sizes: only the first call of each size allocates
+    vector<vector<Segment>> inputs(2);
+    for (int n : {3000, 1000})
+    {
+        for (int i = 0; i < n; ++i)
+        {
+            Point p{coordinate(gen), coordinate(gen)};
+            inputs[n == 1000].push_back({p, {p.x + offset(gen), p.y + offset(gen)}});
+        }
+    }
+
+    Workspace workspace;
+    vector<pair<int, int>> ids;
+    vector<Point> points;
+
+    for (int call = 0; call < 6; ++call)
+    {
+        auto& segments = inputs[call % 2];
+
+        vector<pair<int, int>> expectedIds;
+        vector<Point> expectedPoints;
+        lineSegmentIntersectionSweepLine(segments, expectedIds, expectedPoints);
+
+        ids.clear();
+        points.clear();
+
+        long long before = heapAllocations;
+        lineSegmentIntersectionSweepLine(segments, ids, points, workspace);
+
+        if (call >= 2)
+        {
+            EXPECT_EQ(heapAllocations, before);
+        }
+
+        EXPECT_TRUE(ids == expectedIds);
+        EXPECT_TRUE(points == expectedPoints);
+    }
+}
+
+TEST(lineSegmentIntersectionSweepLine, policies)
+{
+    mt19937 gen(103);
+    uniform_real_distribution<double> coordinate(0., 1000.);
+    uniform_real_distribution<double> offset(-20., 20.);
+
+    // long ones cross many slabs
+    vector<Segment> random;
+    for (int i = 0; i < 40000; ++i)
+    {
+        Point p{coordinate(gen), coordinate(gen)};
+        double scale = i % 100 ? 1. : 20.;
+        random.push_back({p, {p.x + scale * offset(gen), p.y + scale * offset(gen)}});
+    }
+
+    // 5-segment polylines on the lattice: shared endpoints, crossings at
+    // vertices and endpoints at the x of the slab bounds
+    uniform_int_distribution<int> lattice(0, 1000), step(-10, 10);
+
+    vector<Segment> polylines;
+    for (int i = 0; i < 4000; ++i)
+    {
+        Point p{double(lattice(gen)), double(lattice(gen))};
+        for (int j = 0; j < 5; ++j)
+        {
+            Point q = p;
+            while (q.x == p.x)
+                q = {p.x + step(gen), p.y + step(gen)};
+
+            polylines.push_back({p, q});
+            p = q;
+        }
+    }
+
+    for (auto* input : {&random, &polylines})
+    {
+        auto& segments = *input;
+
+        vector<pair<int, int>> expectedIds;
+        vector<Point> expectedPoints;
+        lineSegmentIntersectionSweepLine(seq, segments, expectedIds, expectedPoints);
+
+        vector<pair<int, int>> sweepIds;
+        vector<Point> sweepPoints;
+        lineSegmentIntersectionSweepLine(segments, sweepIds, sweepPoints);
+
+        sort(sweepIds.begin(), sweepIds.end());
+        auto sortedIds = expectedIds;
+        sort(sortedIds.begin(), sortedIds.end());
+        EXPECT_TRUE(sortedIds == sweepIds);
+
+        for (int nThreads : {1, 3, 4})
+        {
+            setThreadCount(nThreads);
+
+            vector<pair<int, int>> ids = {{-1, -1}}, unseqIds;
+            vector<Point> points = {{-1, -1}}, unseqPoints;
+            lineSegmentIntersectionSweepLine(par, segments, ids, points);
+            lineSegmentIntersectionSweepLine(par_unseq, segments, unseqIds, unseqPoints);
+
+            // appended after what was there
+            ASSERT_EQ(ids.front().first, -1);
+            ids.erase(ids.begin());
+            points.erase(points.begin());
+
+            EXPECT_TRUE(ids == expectedIds);
+            EXPECT_TRUE(unseqIds == expectedIds);
+
+            EXPECT_TRUE(equal(points.begin(), points.end(), expectedPoints.begin(), expectedPoints.end(), samePoint<double>));
+        }
+    }
 
-    auto event = eventTree.removeMin();
+    setThreadCount(thread::hardware_concurrency());
 }
@@ -0,0 +1,285 @@
+#include "Point.h"
+#include "Util.h"
+
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <cmath>
+
+#include <gtest/gtest.h>
+
+
+using namespace std;
+
+// An empty set gives a negative radius.
+struct Circle
+{
+    Point center;
+    double radius = -1.;
+
+    template <typename T>
+    bool contains(const BasicPoint<T>& p) const
+    {
+        double dx = p.x - center.x, dy = p.y - center.y;
+        return dx * dx + dy * dy <= radius * radius * (1. + 1e-10);
+    }
+};
+
+template <typename T>
+Circle circleOf(const BasicPoint<T>& a, const BasicPoint<T>& b)
+{
+    Point center = {0.5 * (double(a.x) + b.x), 0.5 * (double(a.y) + b.y)};
+    return {center, 0.5 * hypot(double(b.x) - a.x, double(b.y) - a.y)};
+}
+
+// Circumcircle, or the circle over the farthest two of collinear points.
+template <typename T>
+Circle circleOf(const BasicPoint<T>& a, const BasicPoint<T>& b, const BasicPoint<T>& c)
+{
+    if (orientation(a, b, c) == COLINEAR)
+    {
+        Circle circles[] = {circleOf(a, b), circleOf(a, c), circleOf(b, c)};
+        return *max_element(begin(circles), end(circles), [](const Circle& c1, const Circle& c2) {
+            return c1.radius < c2.radius;
+        });
+    }
+
+    double bx = double(b.x) - a.x, by = double(b.y) - a.y;
+    double cx = double(c.x) - a.x, cy = double(c.y) - a.y;
+
+    double d = 2. * (bx * cy - by * cx);
+    double b2 = bx * bx + by * by, c2 = cx * cx + cy * cy;
+
+    double ux = (cy * b2 - by * c2) / d;
+    double uy = (bx * c2 - cx * b2) / d;
+
+    return {{a.x + ux, a.y + uy}, hypot(ux, uy)};
+}
+
+// Welzl's randomized incremental construction, iterative: expected O(n) over
+// the shuffled order. Shuffles points in place.
+template <typename T, typename Generator>
+Circle welzl(BasicPoint<T>* points, int n, Generator& gen)
+{
+    shuffle(points, points + n, gen);
+
+    Circle circle;
+    for (int i = 0; i < n; ++i)
+    {
+        if (circle.radius >= 0. && circle.contains(points[i]))
+            continue;
+
+        circle = {{double(points[i].x), double(points[i].y)}, 0.};
+        for (int j = 0; j < i; ++j)
+        {
+            if (circle.contains(points[j]))
+                continue;
+
+            circle = circleOf(points[i], points[j]);
+            for (int k = 0; k < j; ++k)
+                if (!circle.contains(points[k]))
+                    circle = circleOf(points[i], points[j], points[k]);
+        }
+    }
+
+    return circle;
+}
+
+// The circle only depends on the hull vertices: sorts points, writes the
+// vertices to hull (room for 2 * n points) and returns their count.
+template <typename T>
+int hullVertices(BasicPoint<T>* points, int n, BasicPoint<T>* hull)
+{
+    int k = monotoneChainHull(points, n, hull);
+
+    return k > 0 ? k - 1 : 0;
+}
+
+// Smallest circle holding all points. With reduceToHull the points are first
+// cut down to their hull vertices by the monotone chain: O(n * log(n))
+// instead of expected O(n), but the randomized passes only see the hull.
+template <typename T>
+Circle minimumEnclosingCircle(const vector<BasicPoint<T>>& points, bool reduceToHull = false)
+{
+    TRACE_SPAN("minimumEnclosingCircle");
+
+    minstd_rand gen;
+
+    vector<BasicPoint<T>> scratch = points;
+    if (!reduceToHull)
+        return welzl(scratch.data(), scratch.size(), gen);
+
+    STATS_PHASE("hull");
+    vector<BasicPoint<T>> hull(2 * scratch.size());
+    int h = hullVertices(scratch.data(), scratch.size(), hull.data());
+
+    STATS_NEXT_PHASE("circle");
+    return welzl(hull.data(), h, gen);
+}
+
+// Circles of many point sets, with the buffers of convexHullBatch: set i is
+// points[offsets[i] .. offsets[i + 1]) and gets circles[i]. The sets are cut
+// into nThreads chunks of about the same number of points, run on the shared
+// pool, and every set shuffles with its own generator seeded by its index, so
+// the circles do not depend on the thread count.
+template <typename T>
+void minimumEnclosingCircleBatch(const vector<BasicPoint<T>>& points, const vector<int>& offsets, vector<Circle>& circles, bool reduceToHull = false, int nThreads = 1)
+{
+    TRACE_SPAN("minimumEnclosingCircleBatch");
+
+    int nSets = max<int>(0, offsets.size() - 1);
+
+    circles.resize(nSets);
+    if (nSets == 0)
+        return;
+
+    auto worker = [&](int firstSet, int lastSet) {
+        TRACE_SPAN("circles");
+
+        int largest = 0;
+        for (int i = firstSet; i < lastSet; ++i)
+            largest = max(largest, offsets[i + 1] - offsets[i]);
+
+        vector<BasicPoint<T>> scratch((reduceToHull ? 3 : 1) * largest);
+        auto* hull = scratch.data() + largest;
+
+        for (int i = firstSet; i < lastSet; ++i)
+        {
+            int n = offsets[i + 1] - offsets[i];
+            copy(points.begin() + offsets[i], points.begin() + offsets[i + 1], scratch.begin());
+
+            minstd_rand gen(i + 1);
+            if (reduceToHull)
+                circles[i] = welzl(hull, hullVertices(scratch.data(), n, hull), gen);
+            else
+                circles[i] = welzl(scratch.data(), n, gen);
+        }
+    };
+
+    forSetRanges(offsets, max(1, min(nThreads, nSets)), worker);
+}
+
+
+// Smallest of the circles through two or three points that hold all points.
+template <typename T>
+double bruteForceRadius(const vector<BasicPoint<T>>& points)
+{
+    if (points.size() == 1)
+        return 0.;
+
+    auto holdsAll = [&](const Circle& c) {
+        return all_of(points.begin(), points.end(), [&](const BasicPoint<T>& p) {
+            return c.contains(p);
+        });
+    };
+
+    double radius = INFINITY;
+    for (int i = 0; i < points.size(); ++i)
+    {
+        for (int j = i + 1; j < points.size(); ++j)
+        {
+            auto c = circleOf(points[i], points[j]);
+            if (c.radius < radius && holdsAll(c))
+                radius = c.radius;
+
+            for (int k = j + 1; k < points.size(); ++k)
+            {
+                auto c = circleOf(points[i], points[j], points[k]);
+                if (c.radius < radius && holdsAll(c))
+                    radius = c.radius;
+            }
+        }
+    }
+
+    return radius;
+}
+
+TEST(minimumEnclosingCircle, simple)
+{
+    // obtuse: the longest side is a diameter
+    auto c = minimumEnclosingCircle(vector<Point>{ {0, 0}, {4, 0}, {2, 1} });
+    EXPECT_NEAR(c.center.x, 2., 1e-12);
+    EXPECT_NEAR(c.center.y, 0., 1e-12);
+    EXPECT_NEAR(c.radius, 2., 1e-12);
+
+    // acute: the circumcircle
+    c = minimumEnclosingCircle(vector<Point>{ {0, 0}, {4, 0}, {2, 3}, {2, 1}, {1, 0.5} });
+    EXPECT_NEAR(c.center.x, 2., 1e-12);
+    EXPECT_NEAR(c.center.y, 5. / 6, 1e-12);
+    EXPECT_NEAR(c.radius, 13. / 6, 1e-12);
+
+    // collinear, one point, none
+    c = minimumEnclosingCircle(vector<Point>{ {1, 1}, {3, 3}, {2, 2}, {0, 0} });
+    EXPECT_NEAR(c.radius, sqrt(4.5), 1e-12);
+
+    c = minimumEnclosingCircle(vector<Point>{ {5, -1}, {5, -1} }, true);
+    EXPECT_EQ(c.radius, 0.);
+    EXPECT_EQ(c.center.x, 5.);
+
+    EXPECT_LT(minimumEnclosingCircle(vector<Point>()).radius, 0.);
+    EXPECT_LT(minimumEnclosingCircle(vector<Point>(), true).radius, 0.);
+}
+
+TEST(minimumEnclosingCircle, random)
+{
+    mt19937 gen(67);
+    normal_distribution<double> coordinate(0., 3.);
+
+    for (int trial = 0; trial < 50; ++trial)
+    {
+        vector<Point> points(1 + trial % 25);
+        for (auto& p : points)
+            p = {coordinate(gen), coordinate(gen)};
+
+        auto c = minimumEnclosingCircle(points);
+        for (const auto& p : points)
+            ASSERT_TRUE(c.contains(p));
+
+        ASSERT_NEAR(c.radius, bruteForceRadius(points), 1e-9);
+        ASSERT_NEAR(minimumEnclosingCircle(points, true).radius, c.radius, 1e-9);
+    }
+}
+
+TEST(minimumEnclosingCircle, batch)
+{
+    mt19937 gen(71);
+    uniform_int_distribution<int> size(0, 60), coordinate(-50, 50);
+
+    vector<BasicPoint<int32_t>> points;
+    vector<int> offsets = {0};
+    for (int i = 0; i < 400; ++i)
+    {
+        int n = size(gen);
+        for (int j = 0; j < n; ++j)
+            points.push_back({coordinate(gen) + 100 * i, coordinate(gen)});
+        offsets.push_back(points.size());
+    }
+
+    vector<Circle> circles, circles1, hullCircles;
+    minimumEnclosingCircleBatch(points, offsets, circles, false, 3);
+    minimumEnclosingCircleBatch(points, offsets, circles1, false, 1);
+    minimumEnclosingCircleBatch(points, offsets, hullCircles, true, 3);
+
+    ASSERT_EQ(circles.size(), offsets.size() - 1);
+
+    for (int i = 0; i + 1 < offsets.size(); ++i)
+    {
+        vector<BasicPoint<int32_t>> set(points.begin() + offsets[i], points.begin() + offsets[i + 1]);
+
+        EXPECT_EQ(circles[i].center.x, circles1[i].center.x);
+        EXPECT_EQ(circles[i].radius, circles1[i].radius);
+
+        if (set.empty())
+        {
+            EXPECT_LT(circles[i].radius, 0.);
+            EXPECT_LT(hullCircles[i].radius, 0.);
+            continue;
+        }
+
+        for (const auto& p : set)
+            ASSERT_TRUE(circles[i].contains(p));
+
+        EXPECT_NEAR(circles[i].radius, minimumEnclosingCircle(set).radius, 1e-9);
+        EXPECT_NEAR(hullCircles[i].radius, circles[i].radius, 1e-9);
+    }
+}
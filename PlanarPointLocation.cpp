@@ -0,0 +1,233 @@
+#include "DataStructures/PersistentAVLTree.h"
+#include "Point.h"
+#include "Segment.h"
+#include "Util.h"
+
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <random>
+
+#include <gtest/gtest.h>
+
+
+using namespace std;
+
+double heightAt(const Segment& s, double x)
+{
+    const auto& p = s.first();
+    const auto& q = s.second();
+
+    return p.y + (q.y - p.y) / (q.x - p.x) * (x - p.x);
+}
+
+// Orders segment ids by the height of the segments at the sweep position x.
+// Inside a slab non-crossing segments never swap, so x only has to be moved
+// to the interior of the slab being built.
+struct SegmentBelow
+{
+    const vector<Segment>* segments;
+    double x;
+
+    bool operator() (int a, int b) const
+    {
+        double ya = heightAt((*segments)[a], x);
+        double yb = heightAt((*segments)[b], x);
+
+        if (ya != yb)
+            return ya < yb;
+
+        return a < b;
+    }
+};
+
+// Slab decomposition of a planar subdivision given by non-crossing segments.
+// Sweeping left to right records one version of the persistent status tree per
+// slab, sharing all unchanged nodes: O(n log n) space, O(log n) query.
+// Queries only read immutable nodes and are safe from any number of threads.
+class SlabPointLocation
+{
+public:
+    explicit SlabPointLocation(const vector<Segment>& segments);
+
+    SlabPointLocation(const SlabPointLocation&) = delete;
+    SlabPointLocation& operator= (const SlabPointLocation&) = delete;
+
+    // Index of the segment directly above p (or through p), -1 if there is none.
+    int segmentAbove(const Point& p) const;
+
+    int slabCount() const;
+
+private:
+    vector<Segment> m_segments;
+
+    vector<double> m_slabX;
+    vector<int> m_slabVersion;
+
+    PersistentAVLTree<int, SegmentBelow> m_status;
+};
+
+SlabPointLocation::SlabPointLocation(const vector<Segment>& segments) :
+    m_segments(segments),
+    m_status(SegmentBelow{&m_segments, 0.})
+{
+    TRACE_SPAN("SlabPointLocation");
+    STATS_PHASE("events");
+
+    struct SweepEvent
+    {
+        double x;
+        bool start;
+        int id;
+    };
+
+    vector<SweepEvent> events;
+    events.reserve(2 * m_segments.size());
+
+    for (int i = 0; i < m_segments.size(); ++i)
+    {
+        // vertical segments never lie strictly above a point inside a slab
+        if (m_segments[i].first().x == m_segments[i].second().x)
+            continue;
+
+        events.push_back({m_segments[i].first().x, true, i});
+        events.push_back({m_segments[i].second().x, false, i});
+    }
+
+    sort(events.begin(), events.end(), [](const SweepEvent& e1, const SweepEvent& e2) {
+        return e1.x < e2.x;
+    });
+
+    STATS_NEXT_PHASE("sweep");
+
+    int version = 0;
+    double previousX = events.empty() ? 0. : events.front().x;
+
+    for (int i = 0; i < events.size();)
+    {
+        double x = events[i].x;
+
+        int groupEnd = i;
+        while (groupEnd < events.size() && events[groupEnd].x == x)
+            ++groupEnd;
+
+        double nextX = groupEnd < events.size() ? events[groupEnd].x : x;
+
+        m_status.comparator().x = 0.5 * (previousX + x);
+        for (int j = i; j < groupEnd; ++j)
+            if (!events[j].start)
+                version = m_status.remove(version, events[j].id);
+
+        m_status.comparator().x = 0.5 * (x + nextX);
+        for (int j = i; j < groupEnd; ++j)
+            if (events[j].start)
+                version = m_status.insert(version, events[j].id);
+
+        m_slabX.push_back(x);
+        m_slabVersion.push_back(version);
+
+        previousX = x;
+        i = groupEnd;
+    }
+}
+
+int SlabPointLocation::segmentAbove(const Point& p) const
+{
+    auto slab = upper_bound(m_slabX.begin(), m_slabX.end(), p.x) - m_slabX.begin() - 1;
+    if (slab < 0)
+        return -1;
+
+    const auto* node = m_status.lowerBound(m_slabVersion[slab], [this, &p](int id) {
+        return heightAt(m_segments[id], p.x) < p.y;
+    });
+
+    return node ? node->key : -1;
+}
+
+inline int SlabPointLocation::slabCount() const
+{
+    return static_cast<int>(m_slabX.size());
+}
+
+int segmentAboveNaive(const vector<Segment>& segments, const Point& p)
+{
+    int best = -1;
+    double bestY = 0.;
+
+    for (int i = 0; i < segments.size(); ++i)
+    {
+        const auto& s = segments[i];
+        if (s.first().x == s.second().x || p.x < s.first().x || p.x >= s.second().x)
+            continue;
+
+        double y = heightAt(s, p.x);
+        if (y >= p.y && (best < 0 || y < bestY))
+        {
+            best = i;
+            bestY = y;
+        }
+    }
+
+    return best;
+}
+
+
+TEST(slabPointLocation, simple)
+{
+    vector<Segment> segments = { {{0, 0}, {10, 0}}, {{0, 5}, {10, 5}}, {{2, 2}, {6, 3}}, {{6, 3}, {9, 1}} };
+
+    SlabPointLocation locator(segments);
+
+    EXPECT_EQ(locator.slabCount(), 5);
+
+    EXPECT_EQ(locator.segmentAbove({1, 1}), 1);
+    EXPECT_EQ(locator.segmentAbove({4, 1}), 2);
+    EXPECT_EQ(locator.segmentAbove({4, 3}), 1);
+    EXPECT_EQ(locator.segmentAbove({7, 1}), 3);
+    EXPECT_EQ(locator.segmentAbove({5, -1}), 0);
+    EXPECT_EQ(locator.segmentAbove({5, 6}), -1);
+    EXPECT_EQ(locator.segmentAbove({-1, 0}), -1);
+    EXPECT_EQ(locator.segmentAbove({11, 0}), -1);
+}
+
+TEST(slabPointLocation, randomBands)
+{
+    mt19937 gen(7);
+    uniform_real_distribution<double> unit(0., 1.);
+
+    // one segment per horizontal band, so no two segments cross
+    vector<Segment> segments;
+    for (int band = 0; band < 500; ++band)
+    {
+        double x1 = 100. * unit(gen);
+        double x2 = 100. * unit(gen);
+        segments.push_back({{x1, band + 0.9 * unit(gen)}, {x2, band + 0.9 * unit(gen)}});
+    }
+
+    SlabPointLocation locator(segments);
+
+    vector<Point> queries(20000);
+    for (auto& q : queries)
+        q = {100. * unit(gen), 500. * unit(gen)};
+
+    vector<int> expected(queries.size());
+    for (int i = 0; i < queries.size(); ++i)
+        expected[i] = segmentAboveNaive(segments, queries[i]);
+
+    const int nThreads = 4;
+    vector<int> output(queries.size());
+    vector<thread> workers;
+
+    for (int t = 0; t < nThreads; ++t)
+    {
+        workers.emplace_back([&, t]() {
+            for (int i = t; i < queries.size(); i += nThreads)
+                output[i] = locator.segmentAbove(queries[i]);
+        });
+    }
+
+    for (auto& worker : workers)
+        worker.join();
+
+    EXPECT_TRUE(output == expected);
+}
@@ -3,49 +3,91 @@
 #include <cstdint>
 #include <ostream>
 #include <cmath>
+#include <type_traits>
 
 
-struct Point
+// Types the predicates of T coordinates are computed in. Product holds the
+// product of two coordinates, Exact the cross product of two coordinate
+// differences: on integers both are exact, for int64 as long as differences
+// fit in 63 bits. float goes through double, which rounds once instead of
+// twice.
+template <typename T>
+struct ScalarTraits
 {
-    double x, y;
+    using Product = T;
+    using Exact = T;
+};
+
+template <>
+struct ScalarTraits<float>
+{
+    using Product = double;
+    using Exact = double;
+};
+
+template <>
+struct ScalarTraits<std::int32_t>
+{
+    using Product = std::int64_t;
+    using Exact = __int128;
+};
+
+template <>
+struct ScalarTraits<std::int64_t>
+{
+    using Product = __int128;
+    using Exact = __int128;
+};
+
+template <typename T>
+struct BasicPoint
+{
+    using Scalar = T;
+    using Product = typename ScalarTraits<T>::Product;
+
+    T x, y;
 
     double mag() const
     {
-        return sqrt(x * x + y * y);
+        return sqrt(double(x) * x + double(y) * y);
     }
 
-    bool operator== (const Point& p) const
+    // exact on integers, within 1e-6 otherwise
+    bool operator== (const BasicPoint& p) const
     {
-        return abs(x - p.x) < 1e-6 && abs(y - p.y) < 1e-6;
+        if constexpr (std::is_integral_v<T>)
+            return x == p.x && y == p.y;
+        else
+            return std::abs(x - p.x) < 1e-6 && std::abs(y - p.y) < 1e-6;
     }
 
-    bool operator!= (const Point& p) const
+    bool operator!= (const BasicPoint& p) const
     {
         return !(p == *this);
     }
 
-    bool operator< (const Point& p) const
+    bool operator< (const BasicPoint& p) const
     {
         return x < p.x;
     }
 
-    bool operator> (const Point& p) const
+    bool operator> (const BasicPoint& p) const
     {
         return x > p.x;
     }
 
-    friend Point operator+ (const Point& p, const Point& q)
+    friend BasicPoint operator+ (const BasicPoint& p, const BasicPoint& q)
     {
-        Point r;
+        BasicPoint r;
         r.x = q.x + p.x;
         r.y = q.y + p.y;
 
         return r;
     }
 
-    friend Point operator- (const Point& p, const Point& q)
+    friend BasicPoint operator- (const BasicPoint& p, const BasicPoint& q)
     {
-        Point r;
+        BasicPoint r;
         r.x = p.x - q.x;
         r.y = p.y - q.y;
 
@@ -53,29 +95,29 @@ struct Point
     }
 
     // cross product
-    friend double operator^ (const Point& p, const Point& q)
+    friend Product operator^ (const BasicPoint& p, const BasicPoint& q)
     {
-        return p.x * q.y - q.x * p.y;
+        return Product(p.x) * q.y - Product(q.x) * p.y;
     }
 
-    double cross(const Point& p) const
+    Product cross(const BasicPoint& p) const
     {
         return *this ^ p;
     }
 
-    friend double operator& (const Point& p, const Point& q)
+    friend Product operator& (const BasicPoint& p, const BasicPoint& q)
     {
-        return p.x * q.x + p.y * q.y;
+        return Product(p.x) * q.x + Product(p.y) * q.y;
     }
 
-    double dot(const Point& p) const
+    Product dot(const BasicPoint& p) const
     {
         return *this & p;
     }
 
-    Point operator* (double val)
+    BasicPoint operator* (double val)
     {
-        Point q;
+        BasicPoint q;
 
         q.x = x * val;
         q.y = y * val;
@@ -83,19 +125,21 @@ struct Point
         return q;
     }
 
-    Point operator/ (std::size_t n)
+    BasicPoint operator/ (std::size_t n)
     {
-        Point q;
+        BasicPoint q;
 
-        q.x = x / n;
-        q.y = y / n;
+        q.x = x / T(n);
+        q.y = y / T(n);
 
         return q;
     }
 
-    friend std::ostream& operator<< (std::ostream& os, const Point& p)
+    friend std::ostream& operator<< (std::ostream& os, const BasicPoint& p)
     {
         os << p.x << ", " << p.y;
         return os;
     }
 };
+
+using Point = BasicPoint<double>;
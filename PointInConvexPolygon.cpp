@@ -0,0 +1,331 @@
+#include "Point.h"
+#include "Util.h"
+
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <random>
+#include <sstream>
+
+#include <gtest/gtest.h>
+
+
+using namespace std;
+
+// Containment queries against a convex polygon in O(log h). The polygon is
+// split into a fan of triangles around its lowest-leftmost vertex; a query
+// finds its wedge of the fan by binary search on the cross product and then
+// tests the one edge closing that wedge. Points on the boundary are inside.
+//
+// The batched query runs the binary searches of a block of points in
+// lockstep: the number of steps only depends on the polygon, so the lanes
+// never diverge and every step is a branch-free loop over the block that the
+// compiler can vectorize.
+class ConvexPolygon
+{
+public:
+    // Accepts the output of the convex hull functions: clockwise or
+    // counter-clockwise, closed ring or not.
+    explicit ConvexPolygon(const vector<Point>& hull);
+
+    bool contains(const Point& p) const;
+
+    // inside[i] tells whether (xs[i], ys[i]) is in the polygon.
+    void contains(const vector<double>& xs, const vector<double>& ys, vector<unsigned char>& inside, int nThreads = 1) const;
+
+    int size() const;
+
+private:
+    static constexpr int BlockSize = 16;
+
+    void containsBlock(const double* xs, const double* ys, int n, unsigned char* inside) const;
+
+    bool containsDegenerate(const Point& p) const;
+
+private:
+    int m_size = 0;
+
+    Point m_pivot;
+
+    // fan vertices in counter-clockwise order, relative to the pivot
+    vector<double> m_x;
+    vector<double> m_y;
+};
+
+ConvexPolygon::ConvexPolygon(const vector<Point>& hull)
+{
+    auto vertices = normalizeConvexPolygon(hull);
+
+    m_size = vertices.size();
+    if (vertices.empty())
+        return;
+
+    auto pivot = min_element(vertices.begin(), vertices.end(), [](const Point& p, const Point& q) {
+        return p.x < q.x || (p.x == q.x && p.y < q.y);
+    });
+    rotate(vertices.begin(), pivot, vertices.end());
+
+    m_pivot = vertices[0];
+    for (int i = 1; i < vertices.size(); ++i)
+    {
+        m_x.push_back(vertices[i].x - m_pivot.x);
+        m_y.push_back(vertices[i].y - m_pivot.y);
+    }
+}
+
+bool ConvexPolygon::contains(const Point& p) const
+{
+    int m = m_x.size();
+    if (m < 2)
+        return containsDegenerate(p);
+
+    double dx = p.x - m_pivot.x;
+    double dy = p.y - m_pivot.y;
+
+    // outside the fan
+    if (m_x[0] * dy - m_y[0] * dx < 0. || m_x[m - 1] * dy - m_y[m - 1] * dx > 0.)
+        return false;
+
+    // last fan vertex with p on its left
+    int base = 0;
+    for (int len = m - 1; len > 1;)
+    {
+        int half = len / 2;
+        if (m_x[base + half] * dy - m_y[base + half] * dx >= 0.)
+            base += half;
+        len -= half;
+    }
+
+    double ex = m_x[base + 1] - m_x[base];
+    double ey = m_y[base + 1] - m_y[base];
+
+    return ex * (dy - m_y[base]) - ey * (dx - m_x[base]) >= 0.;
+}
+
+void ConvexPolygon::contains(const vector<double>& xs, const vector<double>& ys, vector<unsigned char>& inside, int nThreads) const
+{
+    TRACE_SPAN("ConvexPolygon::contains");
+
+    int n = xs.size();
+    inside.resize(n);
+
+    nThreads = max(1, min(nThreads, (n + BlockSize - 1) / BlockSize));
+
+    auto worker = [&](int first, int last) {
+        TRACE_SPAN("blocks");
+
+        for (int i = first; i < last; i += BlockSize)
+            containsBlock(xs.data() + i, ys.data() + i, min(BlockSize, last - i), inside.data() + i);
+    };
+
+    // chunk boundaries on whole blocks
+    int nBlocks = (n + BlockSize - 1) / BlockSize;
+    vector<thread> workers;
+    for (int t = 0; t < nThreads; ++t)
+    {
+        int first = min(n, nBlocks * t / nThreads * BlockSize);
+        int last = min(n, nBlocks * (t + 1) / nThreads * BlockSize);
+
+        if (t + 1 == nThreads)
+            worker(first, last);
+        else
+            workers.emplace_back(worker, first, last);
+    }
+
+    for (auto& w : workers)
+        w.join();
+}
+
+int ConvexPolygon::size() const
+{
+    return m_size;
+}
+
+void ConvexPolygon::containsBlock(const double* xs, const double* ys, int n, unsigned char* inside) const
+{
+    int m = m_x.size();
+    if (m < 2)
+    {
+        for (int j = 0; j < n; ++j)
+            inside[j] = containsDegenerate({xs[j], ys[j]});
+        return;
+    }
+
+    double dx[BlockSize], dy[BlockSize];
+    int base[BlockSize];
+
+    for (int j = 0; j < BlockSize; ++j)
+    {
+        // a short block repeats its last point in the unused lanes
+        int k = min(j, n - 1);
+        dx[j] = xs[k] - m_pivot.x;
+        dy[j] = ys[k] - m_pivot.y;
+        base[j] = 0;
+    }
+
+    const double* vx = m_x.data();
+    const double* vy = m_y.data();
+
+    for (int len = m - 1; len > 1;)
+    {
+        int half = len / 2;
+        for (int j = 0; j < BlockSize; ++j)
+        {
+            int probe = base[j] + half;
+            base[j] += (vx[probe] * dy[j] - vy[probe] * dx[j] >= 0.) ? half : 0;
+        }
+        len -= half;
+    }
+
+    unsigned char result[BlockSize];
+    for (int j = 0; j < BlockSize; ++j)
+    {
+        int b = base[j];
+        double ex = vx[b + 1] - vx[b];
+        double ey = vy[b + 1] - vy[b];
+
+        bool inFan = (vx[0] * dy[j] - vy[0] * dx[j] >= 0.) & (vx[m - 1] * dy[j] - vy[m - 1] * dx[j] <= 0.);
+        bool inTriangle = ex * (dy[j] - vy[b]) - ey * (dx[j] - vx[b]) >= 0.;
+
+        result[j] = inFan & inTriangle;
+    }
+
+    copy(result, result + n, inside);
+}
+
+// A polygon of at most two vertices: p has to be on the point or segment.
+bool ConvexPolygon::containsDegenerate(const Point& p) const
+{
+    if (m_size == 0)
+        return false;
+
+    if (m_size == 1)
+        return p.x == m_pivot.x && p.y == m_pivot.y;
+
+    Point d{p.x - m_pivot.x, p.y - m_pivot.y};
+    Point e{m_x[0], m_y[0]};
+
+    return (e ^ d) == 0. && (e & d) >= 0. && (e & d) <= (e & e);
+}
+
+// O(h) reference: p is on the inner side of every edge of the clockwise ring.
+bool containsNaive(const vector<Point>& hull, const Point& p)
+{
+    for (int i = 0; i + 1 < hull.size(); ++i)
+        if (((hull[i + 1] - hull[i]) ^ (p - hull[i])) > 0.)
+            return false;
+
+    return true;
+}
+
+
+TEST(pointInConvexPolygon, simple)
+{
+    vector<Point> hull = { {0, 4}, {4, 4}, {4, 0}, {0, 0}, {0, 4} };
+    ConvexPolygon polygon(hull);
+
+    EXPECT_EQ(polygon.size(), 4);
+
+    EXPECT_TRUE(polygon.contains({2, 2}));
+    EXPECT_TRUE(polygon.contains({0, 0}));
+    EXPECT_TRUE(polygon.contains({4, 2}));
+    EXPECT_TRUE(polygon.contains({2, 4}));
+    EXPECT_FALSE(polygon.contains({4.1, 2}));
+    EXPECT_FALSE(polygon.contains({-1, -1}));
+    EXPECT_FALSE(polygon.contains({2, -0.1}));
+
+    // collinear boundary points are dropped
+    ConvexPolygon withCollinear({ {0, 4}, {2, 4}, {4, 4}, {4, 0}, {0, 0} });
+    EXPECT_EQ(withCollinear.size(), 4);
+
+    ConvexPolygon segment({ {0, 0}, {1, 1}, {2, 2}, {0, 0} });
+    EXPECT_EQ(segment.size(), 2);
+    EXPECT_TRUE(segment.contains({1, 1}));
+    EXPECT_FALSE(segment.contains({3, 3}));
+    EXPECT_FALSE(segment.contains({1, 0}));
+
+    vector<double> xs = {2, 4.1, 0, 1};
+    vector<double> ys = {2, 2, 0, 5};
+    vector<unsigned char> inside;
+    polygon.contains(xs, ys, inside);
+
+    EXPECT_TRUE((inside == vector<unsigned char>{1, 0, 1, 0}));
+}
+
+TEST(pointInConvexPolygon, random)
+{
+    mt19937 gen(23);
+    uniform_real_distribution<double> coordinate(-4., 5.);
+
+    for (int n : {3, 4, 7, 64, 1000})
+    {
+        auto hull = randomConvexPolygon(gen, n);
+        ConvexPolygon polygon(hull);
+
+        vector<double> xs(10007), ys(10007);
+        for (int i = 0; i < xs.size(); ++i)
+        {
+            xs[i] = coordinate(gen);
+            ys[i] = coordinate(gen);
+        }
+
+        // vertices are on the boundary
+        for (int i = 0; i < hull.size(); ++i)
+        {
+            xs[i] = hull[i].x;
+            ys[i] = hull[i].y;
+        }
+
+        vector<unsigned char> inside;
+        polygon.contains(xs, ys, inside, 4);
+
+        for (int i = 0; i < xs.size(); ++i)
+        {
+            bool expected = i < hull.size() || containsNaive(hull, {xs[i], ys[i]});
+
+            ASSERT_EQ(polygon.contains({xs[i], ys[i]}), expected);
+            ASSERT_EQ(inside[i], expected);
+        }
+    }
+}
+
+TEST(pointInConvexPolygon, trace)
+{
+    mt19937 gen(5);
+    ConvexPolygon polygon(randomConvexPolygon(gen, 50));
+
+    vector<double> xs(1000, 0.5), ys(1000, 0.5);
+    vector<unsigned char> inside;
+
+    resetTrace();
+    polygon.contains(xs, ys, inside, 4);
+
+    ostringstream trace;
+    writeChromeTrace(trace);
+    string json = trace.str();
+
+#ifdef GEOMETRY_TRACE
+    EXPECT_NE(json.find("\"ConvexPolygon::contains\""), string::npos);
+
+    // one span per worker
+    int nBlocks = 0;
+    for (auto at = json.find("\"blocks\""); at != string::npos; at = json.find("\"blocks\"", at + 1))
+        ++nBlocks;
+    EXPECT_EQ(nBlocks, 4);
+
+    // the next workers take over the buffers of the joined ones
+    auto countBuffers = [] {
+        int n = 0;
+        for (auto* b = traceBuffers().load(); b; b = b->next)
+            ++n;
+        return n;
+    };
+
+    int nBuffers = countBuffers();
+    for (int call = 0; call < 3; ++call)
+        polygon.contains(xs, ys, inside, 4);
+    EXPECT_EQ(countBuffers(), nBuffers);
+#else
+    EXPECT_EQ(json.find("\"ph\""), string::npos);
+#endif
+}
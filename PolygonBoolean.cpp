@@ -0,0 +1,927 @@
+#include "Point.h"
+#include "Util.h"
+
+#include <vector>
+#include <set>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <memory_resource>
+
+#include <gtest/gtest.h>
+
+
+using namespace std;
+
+enum BooleanOperation
+{
+    INTERSECTION,
+    UNION,
+    DIFFERENCE,
+    XOR
+};
+
+// Any number of contours in one flat buffer; contour i is
+// points[offsets[i] .. offsets[i + 1]). Inside is defined by the even-odd
+// rule, so holes are just more contours and their orientation does not matter.
+struct PolygonSet
+{
+    vector<Point> points;
+    vector<int> offsets = {0};
+
+    int contourCount() const
+    {
+        return offsets.size() - 1;
+    }
+
+    // A closed ring (front repeated at the end) is accepted as well.
+    void addContour(const vector<Point>& contour)
+    {
+        points.insert(points.end(), contour.begin(), contour.end());
+        offsets.push_back(points.size());
+    }
+
+    void clear()
+    {
+        points.clear();
+        offsets.assign(1, 0);
+    }
+};
+
+// Martinez-Rueda sweep: edges are split at every crossing while the sweep
+// runs, each piece is classified against the other polygon from the piece
+// just below it in the status line, and the pieces that bound the result are
+// chained into contours. Each output contour has the result on its left, so
+// outer boundaries come out counter-clockwise and holes clockwise.
+//
+// Events live in one array addressed by index and all working buffers are
+// members, the status line with a node pool of its own, so a clipper reused
+// across calls stops allocating once its buffers have grown to the largest
+// input. The status and event comparators point back at the clipper, so it is
+// neither copied nor moved.
+class PolygonClipper
+{
+public:
+    PolygonClipper() = default;
+
+    PolygonClipper(const PolygonClipper&) = delete;
+    PolygonClipper& operator= (const PolygonClipper&) = delete;
+
+    void compute(const PolygonSet& subject, const PolygonSet& clipping, BooleanOperation operation, PolygonSet& result);
+
+private:
+    enum EdgeType
+    {
+        NORMAL,
+        NON_CONTRIBUTING,
+        SAME_TRANSITION,
+        DIFFERENT_TRANSITION
+    };
+
+    // Status line order: which of two segments crossing the sweep line is lower.
+    struct SegmentBelow
+    {
+        const PolygonClipper* clipper;
+
+        bool operator() (int a, int b) const
+        {
+            return clipper->compareSegments(a, b) < 0;
+        }
+    };
+
+    // Event queue order, as a max-heap comparator so the front is the next event.
+    struct EventAfter
+    {
+        const PolygonClipper* clipper;
+
+        bool operator() (int a, int b) const
+        {
+            return clipper->compareEvents(a, b) > 0;
+        }
+    };
+
+    using StatusLine = pmr::set<int, SegmentBelow>;
+
+    struct SweepEvent
+    {
+        Point point;
+        bool left;
+        bool isSubject;
+
+        // event at the other endpoint of the segment
+        int other;
+
+        EdgeType type;
+
+        // the segment is an inside-outside transition of its own polygon when going up
+        bool inOut;
+
+        // the closest segment of the other polygon below is an inside-outside transition
+        bool otherInOut;
+
+        bool inResult;
+
+        bool inStatus;
+        StatusLine::iterator position;
+    };
+
+    struct ResultEdge
+    {
+        Point from, to;
+        bool used;
+    };
+
+    void addEdges(const PolygonSet& polygon, bool isSubject);
+
+    int addEvent(const Point& p, bool left, int other, bool isSubject);
+
+    void push(int event);
+
+    int pop();
+
+    void computeFields(int event, int prev);
+
+    bool inResult(int event) const;
+
+    bool resultAbove(int event) const;
+
+    // 0: no crossing, 1: crossing at a point, 2: overlap sharing the left
+    // endpoint, 3: other overlap
+    int possibleIntersection(int e1, int e2);
+
+    void divideSegment(int event, Point p);
+
+    void connectEdges(PolygonSet& result);
+
+    int compareEvents(int e1, int e2) const;
+
+    int compareSegments(int e1, int e2) const;
+
+    bool isBelow(int event, const Point& p) const;
+
+    bool isVertical(int event) const;
+
+private:
+    BooleanOperation m_operation = INTERSECTION;
+
+    vector<SweepEvent> m_events;
+    vector<int> m_queue;
+    pmr::unsynchronized_pool_resource m_statusNodes;
+    StatusLine m_status{SegmentBelow{this}, &m_statusNodes};
+    vector<int> m_processed;
+
+    vector<ResultEdge> m_edges;
+    vector<int> m_edgeOrder;
+    vector<Point> m_contour;
+};
+
+// > 0 when p0, p1, p2 turn counter-clockwise.
+double signedArea(const Point& p0, const Point& p1, const Point& p2)
+{
+    return (p0.x - p2.x) * (p1.y - p2.y) - (p1.x - p2.x) * (p0.y - p2.y);
+}
+
+// Crossing of segments a1a2 and b1b2: 0 points, 1 point or the 2 ends of
+// their overlap. Touching endpoints are returned exactly.
+int segmentIntersection(const Point& a1, const Point& a2, const Point& b1, const Point& b2, Point& i1, Point& i2)
+{
+    Point va = a2 - a1;
+    Point vb = b2 - b1;
+    Point e = b1 - a1;
+
+    auto along = [&a1, &va](double s) {
+        return Point{a1.x + s * va.x, a1.y + s * va.y};
+    };
+
+    double kross = va ^ vb;
+    if (kross != 0.)
+    {
+        double s = (e ^ vb) / kross;
+        if (s < 0. || s > 1.)
+            return 0;
+
+        double t = (e ^ va) / kross;
+        if (t < 0. || t > 1.)
+            return 0;
+
+        if (s == 0. || s == 1.)
+            i1 = along(s);
+        else if (t == 0. || t == 1.)
+            i1 = Point{b1.x + t * vb.x, b1.y + t * vb.y};
+        else
+            i1 = along(s);
+
+        return 1;
+    }
+
+    // parallel
+    if ((e ^ va) != 0.)
+        return 0;
+
+    double lengthA = va & va;
+    double sa = (va & e) / lengthA;
+    double sb = sa + (va & vb) / lengthA;
+    double sMin = min(sa, sb);
+    double sMax = max(sa, sb);
+
+    if (sMin > 1. || sMax < 0.)
+        return 0;
+
+    if (sMin == 1.)
+    {
+        i1 = a2;
+        return 1;
+    }
+
+    if (sMax == 0.)
+    {
+        i1 = a1;
+        return 1;
+    }
+
+    i1 = sMin > 0. ? along(sMin) : a1;
+    i2 = sMax < 1. ? along(sMax) : a2;
+
+    return 2;
+}
+
+void PolygonClipper::compute(const PolygonSet& subject, const PolygonSet& clipping, BooleanOperation operation, PolygonSet& result)
+{
+    m_operation = operation;
+
+    m_events.clear();
+    m_queue.clear();
+    m_status.clear();
+    m_processed.clear();
+
+    STATS_PHASE("events");
+    addEdges(subject, true);
+    addEdges(clipping, false);
+
+    STATS_NEXT_PHASE("sweep");
+    while (!m_queue.empty())
+    {
+        int event = pop();
+        m_processed.push_back(event);
+
+        if (m_events[event].left)
+        {
+            auto inserted = m_status.insert(event);
+            auto it = inserted.first;
+
+            m_events[event].inStatus = inserted.second;
+            m_events[event].position = it;
+
+            int prev = it == m_status.begin() ? -1 : *std::prev(it);
+            int next = std::next(it) == m_status.end() ? -1 : *std::next(it);
+
+            computeFields(event, prev);
+
+            if (next >= 0 && possibleIntersection(event, next) == 2)
+            {
+                computeFields(event, prev);
+                computeFields(next, event);
+            }
+
+            if (prev >= 0 && possibleIntersection(prev, event) == 2)
+            {
+                auto prevIt = m_events[prev].position;
+                int prevPrev = prevIt == m_status.begin() ? -1 : *std::prev(prevIt);
+
+                computeFields(prev, prevPrev);
+                computeFields(event, prev);
+            }
+        }
+        else
+        {
+            int left = m_events[event].other;
+            if (!m_events[left].inStatus)
+                continue;
+
+            auto it = m_events[left].position;
+            int prev = it == m_status.begin() ? -1 : *std::prev(it);
+            int next = std::next(it) == m_status.end() ? -1 : *std::next(it);
+
+            m_status.erase(it);
+            m_events[left].inStatus = false;
+
+            if (prev >= 0 && next >= 0)
+                possibleIntersection(prev, next);
+        }
+    }
+
+    STATS_NEXT_PHASE("connect");
+    connectEdges(result);
+}
+
+void PolygonClipper::addEdges(const PolygonSet& polygon, bool isSubject)
+{
+    for (int c = 0; c < polygon.contourCount(); ++c)
+    {
+        int first = polygon.offsets[c];
+        int last = polygon.offsets[c + 1];
+
+        for (int i = first; i < last; ++i)
+        {
+            const auto& p = polygon.points[i];
+            const auto& q = polygon.points[i + 1 < last ? i + 1 : first];
+
+            if (samePoint(p, q))
+                continue;
+
+            int e1 = addEvent(p, false, -1, isSubject);
+            int e2 = addEvent(q, false, e1, isSubject);
+            m_events[e1].other = e2;
+
+            if (compareEvents(e1, e2) > 0)
+                m_events[e2].left = true;
+            else
+                m_events[e1].left = true;
+
+            push(e1);
+            push(e2);
+        }
+    }
+}
+
+int PolygonClipper::addEvent(const Point& p, bool left, int other, bool isSubject)
+{
+    m_events.push_back({p, left, isSubject, other, NORMAL, false, false, false, false, {}});
+    return m_events.size() - 1;
+}
+
+void PolygonClipper::push(int event)
+{
+    m_queue.push_back(event);
+    push_heap(m_queue.begin(), m_queue.end(), EventAfter{this});
+}
+
+int PolygonClipper::pop()
+{
+    pop_heap(m_queue.begin(), m_queue.end(), EventAfter{this});
+    int event = m_queue.back();
+    m_queue.pop_back();
+
+    return event;
+}
+
+void PolygonClipper::computeFields(int event, int prev)
+{
+    auto& e = m_events[event];
+
+    if (prev < 0)
+    {
+        e.inOut = false;
+        e.otherInOut = true;
+    }
+    else
+    {
+        const auto& p = m_events[prev];
+
+        if (e.isSubject == p.isSubject)
+        {
+            e.inOut = !p.inOut;
+            e.otherInOut = p.otherInOut;
+        }
+        else
+        {
+            e.inOut = !p.otherInOut;
+            e.otherInOut = isVertical(prev) ? !p.inOut : p.inOut;
+        }
+    }
+
+    e.inResult = inResult(event);
+}
+
+bool PolygonClipper::inResult(int event) const
+{
+    const auto& e = m_events[event];
+
+    switch (e.type)
+    {
+    case NORMAL:
+        switch (m_operation)
+        {
+        case INTERSECTION:
+            return !e.otherInOut;
+        case UNION:
+            return e.otherInOut;
+        case DIFFERENCE:
+            return e.isSubject == e.otherInOut;
+        case XOR:
+            return true;
+        }
+        break;
+    case SAME_TRANSITION:
+        return m_operation == INTERSECTION || m_operation == UNION;
+    case DIFFERENT_TRANSITION:
+        return m_operation == DIFFERENCE;
+    case NON_CONTRIBUTING:
+        return false;
+    }
+
+    return false;
+}
+
+// Whether the result lies above the segment of a left event; for vertical
+// segments "above" is the left side of the segment walked upwards.
+bool PolygonClipper::resultAbove(int event) const
+{
+    const auto& e = m_events[event];
+
+    bool ownAbove = !e.inOut;
+    bool otherAbove = !e.otherInOut;
+
+    if (e.type == SAME_TRANSITION)
+        otherAbove = ownAbove;
+    else if (e.type == DIFFERENT_TRANSITION)
+        otherAbove = !ownAbove;
+
+    bool subjectAbove = e.isSubject ? ownAbove : otherAbove;
+    bool clippingAbove = e.isSubject ? otherAbove : ownAbove;
+
+    switch (m_operation)
+    {
+    case INTERSECTION:
+        return subjectAbove && clippingAbove;
+    case UNION:
+        return subjectAbove || clippingAbove;
+    case DIFFERENCE:
+        return subjectAbove && !clippingAbove;
+    case XOR:
+        return subjectAbove != clippingAbove;
+    }
+
+    return false;
+}
+
+int PolygonClipper::possibleIntersection(int e1, int e2)
+{
+    const Point a1 = m_events[e1].point;
+    const Point a2 = m_events[m_events[e1].other].point;
+    const Point b1 = m_events[e2].point;
+    const Point b2 = m_events[m_events[e2].other].point;
+
+    Point i1, i2;
+    int nIntersections = segmentIntersection(a1, a2, b1, b2, i1, i2);
+
+    if (nIntersections == 0)
+        return 0;
+
+    // touching at a shared endpoint
+    if (nIntersections == 1 && (samePoint(a1, b1) || samePoint(a2, b2)))
+        return 0;
+
+    // overlapping edges of the same polygon are left alone
+    if (nIntersections == 2 && m_events[e1].isSubject == m_events[e2].isSubject)
+        return 0;
+
+    if (nIntersections == 1)
+    {
+        if (!samePoint(a1, i1) && !samePoint(a2, i1))
+            divideSegment(e1, i1);
+
+        if (!samePoint(b1, i1) && !samePoint(b2, i1))
+            divideSegment(e2, i1);
+
+        return 1;
+    }
+
+    // overlap: the endpoints in event order, an endpoint shared by both counted once
+    int sorted[4];
+    int n = 0;
+
+    bool leftCoincide = samePoint(a1, b1);
+    bool rightCoincide = samePoint(a2, b2);
+
+    if (!leftCoincide)
+    {
+        sorted[n++] = compareEvents(e1, e2) > 0 ? e2 : e1;
+        sorted[n++] = compareEvents(e1, e2) > 0 ? e1 : e2;
+    }
+
+    int r1 = m_events[e1].other;
+    int r2 = m_events[e2].other;
+
+    if (!rightCoincide)
+    {
+        sorted[n++] = compareEvents(r1, r2) > 0 ? r2 : r1;
+        sorted[n++] = compareEvents(r1, r2) > 0 ? r1 : r2;
+    }
+
+    if (leftCoincide)
+    {
+        // one piece is kept for both polygons, the other one never contributes
+        m_events[e2].type = NON_CONTRIBUTING;
+        m_events[e1].type = m_events[e2].inOut == m_events[e1].inOut ? SAME_TRANSITION : DIFFERENT_TRANSITION;
+
+        if (!rightCoincide)
+            divideSegment(m_events[sorted[1]].other, m_events[sorted[0]].point);
+
+        return 2;
+    }
+
+    if (rightCoincide)
+    {
+        divideSegment(sorted[0], m_events[sorted[1]].point);
+        return 3;
+    }
+
+    if (sorted[0] != m_events[sorted[3]].other)
+    {
+        // neither segment contains the other
+        divideSegment(sorted[0], m_events[sorted[1]].point);
+        divideSegment(sorted[1], m_events[sorted[2]].point);
+        return 3;
+    }
+
+    // one segment contains the other
+    divideSegment(sorted[0], m_events[sorted[1]].point);
+    divideSegment(m_events[sorted[3]].other, m_events[sorted[2]].point);
+
+    return 3;
+}
+
+// Splits the segment of a left event at p into two segments. p is taken by
+// value: it often refers to another event and the event array may grow.
+void PolygonClipper::divideSegment(int event, Point p)
+{
+    int other = m_events[event].other;
+    bool isSubject = m_events[event].isSubject;
+
+    int right = addEvent(p, false, event, isSubject);
+    int left = addEvent(p, true, other, isSubject);
+
+    // rounding may put p past the old right endpoint: then the roles swap
+    if (compareEvents(left, other) > 0)
+    {
+        m_events[other].left = true;
+        m_events[left].left = false;
+    }
+
+    m_events[other].other = left;
+    m_events[event].other = right;
+
+    push(left);
+    push(right);
+}
+
+// Chains the result edges, each directed with the result on its left, into
+// contours. Walking from vertex to vertex along unused outgoing edges always
+// closes up since every vertex has as many edges leaving as arriving.
+void PolygonClipper::connectEdges(PolygonSet& result)
+{
+    result.clear();
+    m_edges.clear();
+
+    for (int event : m_processed)
+    {
+        const auto& e = m_events[event];
+        if (!e.left || !e.inResult)
+            continue;
+
+        const auto& p = e.point;
+        const auto& q = m_events[e.other].point;
+
+        if (resultAbove(event))
+            m_edges.push_back({p, q, false});
+        else
+            m_edges.push_back({q, p, false});
+    }
+
+    auto before = [](const Point& p, const Point& q) {
+        return p.x < q.x || (p.x == q.x && p.y < q.y);
+    };
+
+    m_edgeOrder.resize(m_edges.size());
+    iota(m_edgeOrder.begin(), m_edgeOrder.end(), 0);
+    sort(m_edgeOrder.begin(), m_edgeOrder.end(), [this, &before](int a, int b) {
+        return before(m_edges[a].from, m_edges[b].from);
+    });
+
+    for (int start : m_edgeOrder)
+    {
+        if (m_edges[start].used)
+            continue;
+
+        m_contour.clear();
+
+        int edge = start;
+        while (edge >= 0)
+        {
+            m_edges[edge].used = true;
+            m_contour.push_back(m_edges[edge].from);
+
+            const auto to = m_edges[edge].to;
+            if (samePoint(to, m_edges[start].from))
+                break;
+
+            auto it = lower_bound(m_edgeOrder.begin(), m_edgeOrder.end(), to, [this, &before](int e, const Point& p) {
+                return before(m_edges[e].from, p);
+            });
+
+            edge = -1;
+            for (; it != m_edgeOrder.end() && samePoint(m_edges[*it].from, to); ++it)
+            {
+                if (!m_edges[*it].used)
+                {
+                    edge = *it;
+                    break;
+                }
+            }
+        }
+
+        // drop the vertices that only split a straight run
+        int n = 0;
+        for (int i = 0; i < m_contour.size(); ++i)
+        {
+            const auto& p = n ? m_contour[n - 1] : m_contour.back();
+            const auto& q = m_contour[i];
+            const auto& r = m_contour[(i + 1) % m_contour.size()];
+
+            if (signedArea(p, q, r) != 0.)
+                m_contour[n++] = q;
+        }
+        m_contour.resize(n);
+
+        if (m_contour.size() >= 3)
+            result.addContour(m_contour);
+    }
+}
+
+int PolygonClipper::compareEvents(int e1, int e2) const
+{
+    const auto& a = m_events[e1];
+    const auto& b = m_events[e2];
+
+    if (a.point.x != b.point.x)
+        return a.point.x > b.point.x ? 1 : -1;
+
+    if (a.point.y != b.point.y)
+        return a.point.y > b.point.y ? 1 : -1;
+
+    // same point: right endpoints first
+    if (a.left != b.left)
+        return a.left ? 1 : -1;
+
+    // both left or both right: the lower segment first
+    if (signedArea(a.point, m_events[a.other].point, m_events[b.other].point) != 0.)
+        return !isBelow(e1, m_events[b.other].point) ? 1 : -1;
+
+    return !a.isSubject && b.isSubject ? 1 : -1;
+}
+
+int PolygonClipper::compareSegments(int e1, int e2) const
+{
+    if (e1 == e2)
+        return 0;
+
+    const auto& a = m_events[e1];
+    const auto& b = m_events[e2];
+    const auto& aOther = m_events[a.other].point;
+    const auto& bOther = m_events[b.other].point;
+
+    if (signedArea(a.point, aOther, b.point) != 0. || signedArea(a.point, aOther, bOther) != 0.)
+    {
+        // not collinear
+        if (samePoint(a.point, b.point))
+            return isBelow(e1, bOther) ? -1 : 1;
+
+        if (a.point.x == b.point.x)
+            return a.point.y < b.point.y ? -1 : 1;
+
+        // compare against the segment that was inserted first
+        if (compareEvents(e1, e2) > 0)
+            return !isBelow(e2, a.point) ? -1 : 1;
+
+        return isBelow(e1, b.point) ? -1 : 1;
+    }
+
+    if (a.isSubject != b.isSubject)
+        return a.isSubject ? -1 : 1;
+
+    // collinear edges of the same polygon
+    if (samePoint(a.point, b.point))
+    {
+        if (samePoint(aOther, bOther))
+            return 0;
+
+        return e1 < e2 ? -1 : 1;
+    }
+
+    return compareEvents(e1, e2) > 0 ? 1 : -1;
+}
+
+// Whether p lies above the line through the segment of the event.
+bool PolygonClipper::isBelow(int event, const Point& p) const
+{
+    const auto& e = m_events[event];
+    const auto& other = m_events[e.other].point;
+
+    return e.left ? signedArea(e.point, other, p) > 0. : signedArea(other, e.point, p) > 0.;
+}
+
+bool PolygonClipper::isVertical(int event) const
+{
+    return m_events[event].point.x == m_events[m_events[event].other].point.x;
+}
+
+// O((n + k) * log(n)) for n edges and k crossings.
+void polygonBoolean(const PolygonSet& subject, const PolygonSet& clipping, BooleanOperation operation, PolygonSet& result)
+{
+    TRACE_SPAN("polygonBoolean");
+
+    PolygonClipper clipper;
+    clipper.compute(subject, clipping, operation, result);
+}
+
+
+double area(const PolygonSet& polygon)
+{
+    double a = 0.;
+
+    for (int c = 0; c < polygon.contourCount(); ++c)
+    {
+        int first = polygon.offsets[c];
+        int last = polygon.offsets[c + 1];
+
+        for (int i = first; i < last; ++i)
+            a += polygon.points[i] ^ polygon.points[i + 1 < last ? i + 1 : first];
+    }
+
+    return a / 2.;
+}
+
+// even-odd rule
+bool inside(const PolygonSet& polygon, const Point& p)
+{
+    bool in = false;
+
+    for (int c = 0; c < polygon.contourCount(); ++c)
+    {
+        int first = polygon.offsets[c];
+        int last = polygon.offsets[c + 1];
+
+        for (int i = first, j = last - 1; i < last; j = i++)
+        {
+            const auto& a = polygon.points[i];
+            const auto& b = polygon.points[j];
+
+            if ((a.y > p.y) != (b.y > p.y) && p.x < a.x + (p.y - a.y) * (b.x - a.x) / (b.y - a.y))
+                in = !in;
+        }
+    }
+
+    return in;
+}
+
+bool expected(BooleanOperation operation, bool inSubject, bool inClipping)
+{
+    switch (operation)
+    {
+    case INTERSECTION:
+        return inSubject && inClipping;
+    case UNION:
+        return inSubject || inClipping;
+    case DIFFERENCE:
+        return inSubject && !inClipping;
+    case XOR:
+        return inSubject != inClipping;
+    }
+
+    return false;
+}
+
+void checkBoolean(const PolygonSet& subject, const PolygonSet& clipping, mt19937& gen, double lo, double hi)
+{
+    uniform_real_distribution<double> coordinate(lo, hi);
+
+    PolygonClipper clipper;
+    PolygonSet results[4];
+
+    for (int op = INTERSECTION; op <= XOR; ++op)
+    {
+        auto operation = static_cast<BooleanOperation>(op);
+        clipper.compute(subject, clipping, operation, results[op]);
+
+        for (int i = 0; i < 2000; ++i)
+        {
+            Point p{coordinate(gen), coordinate(gen)};
+            ASSERT_EQ(inside(results[op], p), expected(operation, inside(subject, p), inside(clipping, p)));
+        }
+    }
+
+    // outer contours counter-clockwise, holes clockwise: signed areas add up
+    EXPECT_GE(area(results[INTERSECTION]), 0.);
+    EXPECT_GE(area(results[DIFFERENCE]), 0.);
+    EXPECT_NEAR(area(results[UNION]), area(results[INTERSECTION]) + area(results[XOR]), 1e-6);
+}
+
+TEST(polygonBoolean, simple)
+{
+    PolygonSet subject, clipping, result;
+    subject.addContour({ {0, 0}, {2, 0}, {2, 2}, {0, 2} });
+    clipping.addContour({ {1, 1}, {3, 1}, {3, 3}, {1, 3} });
+
+    polygonBoolean(subject, clipping, INTERSECTION, result);
+    ASSERT_EQ(result.contourCount(), 1);
+    EXPECT_DOUBLE_EQ(area(result), 1.);
+
+    polygonBoolean(subject, clipping, UNION, result);
+    ASSERT_EQ(result.contourCount(), 1);
+    EXPECT_EQ(result.points.size(), 8);
+    EXPECT_DOUBLE_EQ(area(result), 7.);
+
+    polygonBoolean(subject, clipping, DIFFERENCE, result);
+    EXPECT_DOUBLE_EQ(area(result), 3.);
+
+    polygonBoolean(subject, clipping, XOR, result);
+    EXPECT_DOUBLE_EQ(area(result), 6.);
+
+    // a hole: the difference of nested squares keeps a clockwise inner contour
+    clipping.clear();
+    clipping.addContour({ {0.5, 0.5}, {1.5, 0.5}, {1.5, 1.5}, {0.5, 1.5}, {0.5, 0.5} });
+
+    polygonBoolean(subject, clipping, DIFFERENCE, result);
+    ASSERT_EQ(result.contourCount(), 2);
+    EXPECT_DOUBLE_EQ(area(result), 3.);
+
+    // shared edges
+    clipping.clear();
+    clipping.addContour({ {2, 0}, {4, 0}, {4, 2}, {2, 2} });
+
+    polygonBoolean(subject, clipping, UNION, result);
+    ASSERT_EQ(result.contourCount(), 1);
+    EXPECT_EQ(result.points.size(), 4);
+    EXPECT_DOUBLE_EQ(area(result), 8.);
+
+    polygonBoolean(subject, clipping, INTERSECTION, result);
+    EXPECT_EQ(result.contourCount(), 0);
+
+    // with an empty operand
+    polygonBoolean(subject, PolygonSet(), UNION, result);
+    EXPECT_DOUBLE_EQ(area(result), 4.);
+
+    polygonBoolean(subject, PolygonSet(), INTERSECTION, result);
+    EXPECT_EQ(result.contourCount(), 0);
+}
+
+TEST(polygonBoolean, random)
+{
+    mt19937 gen(17);
+    uniform_real_distribution<double> unit(0., 1.);
+
+    // star-shaped polygons, several per set
+    auto star = [&gen, &unit](Point center, double radius, int n) {
+        vector<double> angles(n);
+        for (auto& a : angles)
+            a = unit(gen) * 2. * M_PI;
+        sort(angles.begin(), angles.end());
+
+        vector<Point> contour;
+        for (double a : angles)
+        {
+            double r = radius * (0.3 + 0.7 * unit(gen));
+            contour.push_back({center.x + r * cos(a), center.y + r * sin(a)});
+        }
+        return contour;
+    };
+
+    for (int round = 0; round < 20; ++round)
+    {
+        PolygonSet subject, clipping;
+        for (int i = 0; i < 3; ++i)
+        {
+            subject.addContour(star({unit(gen) * 10., unit(gen) * 10.}, 4., 30));
+            clipping.addContour(star({unit(gen) * 10., unit(gen) * 10.}, 4., 30));
+        }
+
+        checkBoolean(subject, clipping, gen, -5., 15.);
+    }
+}
+
+TEST(polygonBoolean, grid)
+{
+    // axis-aligned polygons on a coarse grid: many overlapping edges and shared vertices
+    mt19937 gen(19);
+    uniform_int_distribution<int> coordinate(0, 6);
+
+    auto box = [&gen, &coordinate]() {
+        int x0 = coordinate(gen), x1 = coordinate(gen), y0 = coordinate(gen), y1 = coordinate(gen);
+        if (x0 == x1)
+            ++x1;
+        if (y0 == y1)
+            ++y1;
+
+        return vector<Point>{ {double(x0), double(y0)}, {double(x1), double(y0)}, {double(x1), double(y1)}, {double(x0), double(y1)} };
+    };
+
+    for (int round = 0; round < 200; ++round)
+    {
+        PolygonSet subject, clipping;
+        subject.addContour(box());
+        clipping.addContour(box());
+
+        checkBoolean(subject, clipping, gen, -1., 8.);
+    }
+}
@@ -0,0 +1,255 @@
+#include "Point.h"
+#include "Util.h"
+
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include <limits>
+#include <random>
+
+#include <gtest/gtest.h>
+
+
+using namespace std;
+
+// All functions take a hull as the convex hull functions return it and run in
+// O(h) over its vertices: as the reference edge turns around the polygon the
+// vertices extreme in its direction only ever move forward.
+
+// Farthest pair of vertices.
+double hullDiameter(const vector<Point>& hull, pair<Point, Point>& farthest)
+{
+    auto p = normalizeConvexPolygon(hull);
+    int n = p.size();
+
+    if (n == 0)
+        return 0.;
+
+    farthest = {p[0], p[0]};
+    if (n == 1)
+        return 0.;
+
+    double best = -1.;
+    auto check = [&best, &farthest](const Point& a, const Point& b) {
+        Point d = a - b;
+        if ((d & d) > best)
+        {
+            best = d & d;
+            farthest = {a, b};
+        }
+    };
+
+    // antipodal pairs: j is the vertex farthest from the edge (i, i + 1)
+    for (int i = 0, j = 1; i < n; ++i)
+    {
+        int next = (i + 1) % n;
+        Point edge = p[next] - p[i];
+
+        while ((edge ^ (p[(j + 1) % n] - p[j])) > 0.)
+            j = (j + 1) % n;
+
+        check(p[i], p[j]);
+        check(p[next], p[j]);
+    }
+
+    return sqrt(best);
+}
+
+// Smallest distance between two parallel lines enclosing the hull.
+double hullWidth(const vector<Point>& hull)
+{
+    auto p = normalizeConvexPolygon(hull);
+    int n = p.size();
+
+    if (n < 3)
+        return 0.;
+
+    double best = numeric_limits<double>::max();
+
+    for (int i = 0, j = 1; i < n; ++i)
+    {
+        Point edge = p[(i + 1) % n] - p[i];
+
+        while ((edge ^ (p[(j + 1) % n] - p[j])) > 0.)
+            j = (j + 1) % n;
+
+        best = min(best, (edge ^ (p[j] - p[i])) / edge.mag());
+    }
+
+    return best;
+}
+
+// Enclosing rectangle minimizing cost(width, height). Some side of the
+// optimal rectangle is flush with a hull edge for both area and perimeter,
+// so every edge is tried with calipers on the three other sides.
+template <typename Cost>
+double minimumRectangle(const vector<Point>& hull, vector<Point>& rectangle, Cost cost)
+{
+    rectangle.clear();
+
+    auto p = normalizeConvexPolygon(hull);
+    int n = p.size();
+
+    if (n == 0)
+        return 0.;
+
+    if (n == 1)
+    {
+        rectangle.assign(5, p[0]);
+        return cost(0., 0.);
+    }
+
+    auto dot = [](const Point& a, const Point& b) {
+        return a & b;
+    };
+
+    double best = numeric_limits<double>::max();
+
+    int right = 0, top = 0, left = 0;
+    for (int i = 0; i < n; ++i)
+    {
+        Point edge = p[(i + 1) % n] - p[i];
+        double length = edge.mag();
+
+        Point u{edge.x / length, edge.y / length};
+        Point normal{-u.y, u.x};
+
+        if (i == 0)
+        {
+            for (int k = 1; k < n; ++k)
+            {
+                if (dot(p[k], u) > dot(p[right], u))
+                    right = k;
+                if (dot(p[k], normal) > dot(p[top], normal))
+                    top = k;
+                if (dot(p[k], u) < dot(p[left], u))
+                    left = k;
+            }
+        }
+        else
+        {
+            while (dot(p[(right + 1) % n], u) > dot(p[right], u))
+                right = (right + 1) % n;
+            while (dot(p[(top + 1) % n], normal) > dot(p[top], normal))
+                top = (top + 1) % n;
+            while (dot(p[(left + 1) % n], u) < dot(p[left], u))
+                left = (left + 1) % n;
+        }
+
+        double lo = dot(p[left] - p[i], u);
+        double hi = dot(p[right] - p[i], u);
+        double height = dot(p[top] - p[i], normal);
+
+        double c = cost(hi - lo, height);
+        if (c < best)
+        {
+            best = c;
+
+            Point c0 = p[i] + u * lo;
+            Point c1 = p[i] + u * hi;
+            Point c2 = c1 + normal * height;
+            Point c3 = c0 + normal * height;
+
+            // clockwise closed ring, like the hull functions
+            rectangle = {c0, c3, c2, c1, c0};
+        }
+    }
+
+    return best;
+}
+
+double minimumAreaRectangle(const vector<Point>& hull, vector<Point>& rectangle)
+{
+    return minimumRectangle(hull, rectangle, [](double w, double h) {
+        return w * h;
+    });
+}
+
+double minimumPerimeterRectangle(const vector<Point>& hull, vector<Point>& rectangle)
+{
+    return minimumRectangle(hull, rectangle, [](double w, double h) {
+        return 2. * (w + h);
+    });
+}
+
+
+TEST(rotatingCalipers, simple)
+{
+    vector<Point> square = { {0, 1}, {1, 2}, {2, 1}, {1, 0}, {0, 1} };
+
+    pair<Point, Point> farthest;
+    EXPECT_DOUBLE_EQ(hullDiameter(square, farthest), 2.);
+    EXPECT_DOUBLE_EQ((farthest.first - farthest.second).mag(), 2.);
+
+    EXPECT_DOUBLE_EQ(hullWidth(square), sqrt(2.));
+
+    vector<Point> rectangle;
+    EXPECT_NEAR(minimumAreaRectangle(square, rectangle), 2., 1e-12);
+    EXPECT_EQ(rectangle.size(), 5);
+
+    for (const auto& corner : rectangle)
+    {
+        bool isVertex = false;
+        for (const auto& p : square)
+            isVertex = isVertex || corner == p;
+        EXPECT_TRUE(isVertex);
+    }
+
+    EXPECT_NEAR(minimumPerimeterRectangle(square, rectangle), 4. * sqrt(2.), 1e-12);
+
+    vector<Point> triangle = { {0, 0}, {0, 1}, {10, 0}, {0, 0} };
+    EXPECT_NEAR(minimumAreaRectangle(triangle, rectangle), 10., 1e-9);
+
+    vector<Point> segment = { {0, 0}, {3, 4}, {0, 0} };
+    EXPECT_DOUBLE_EQ(hullDiameter(segment, farthest), 5.);
+    EXPECT_DOUBLE_EQ(hullWidth(segment), 0.);
+    EXPECT_NEAR(minimumPerimeterRectangle(segment, rectangle), 10., 1e-12);
+}
+
+TEST(rotatingCalipers, random)
+{
+    mt19937 gen(29);
+
+    for (int n : {3, 4, 5, 17, 100, 1000})
+    {
+        auto hull = randomConvexPolygon(gen, n, 3., 1.5);
+
+        double diameter = 0., width = numeric_limits<double>::max();
+        double area = numeric_limits<double>::max(), perimeter = numeric_limits<double>::max();
+
+        // O(h^2): every edge against every vertex
+        for (int i = 0; i + 1 < hull.size(); ++i)
+        {
+            Point edge = hull[i + 1] - hull[i];
+            Point u{edge.x / edge.mag(), edge.y / edge.mag()};
+            Point normal{-u.y, u.x};
+
+            double lo = 0., hi = 0., height = 0.;
+            for (const auto& p : hull)
+            {
+                diameter = max(diameter, (p - hull[i]).mag());
+
+                lo = min(lo, (p - hull[i]) & u);
+                hi = max(hi, (p - hull[i]) & u);
+                height = max(height, abs((p - hull[i]) & normal));
+            }
+
+            width = min(width, height);
+            area = min(area, (hi - lo) * height);
+            perimeter = min(perimeter, 2. * (hi - lo + height));
+        }
+
+        pair<Point, Point> farthest;
+        vector<Point> rectangle;
+
+        EXPECT_NEAR(hullDiameter(hull, farthest), diameter, 1e-9);
+        EXPECT_NEAR(hullWidth(hull), width, 1e-9);
+        EXPECT_NEAR(minimumAreaRectangle(hull, rectangle), area, 1e-9);
+        EXPECT_NEAR(minimumPerimeterRectangle(hull, rectangle), perimeter, 1e-9);
+
+        // the rectangle encloses the hull
+        for (int i = 0; i + 1 < rectangle.size(); ++i)
+            for (const auto& p : hull)
+                ASSERT_LE((rectangle[i + 1] - rectangle[i]) ^ (p - rectangle[i]), 1e-9);
+    }
+}
@@ -2,16 +2,17 @@
 
 #include "Point.h"
 
-struct Segment
+template <typename T>
+struct BasicSegment
 {
-    Point p;
-    Point q;
+    BasicPoint<T> p;
+    BasicPoint<T> q;
 
     int id;
 
     double value;
 
-    Segment(const Point& p_, const Point& q_) :
+    BasicSegment(const BasicPoint<T>& p_, const BasicPoint<T>& q_) :
         id(-1),
         p(p_),
         q(q_)
@@ -19,7 +20,7 @@ struct Segment
         calculateValue(first().x);
     }
 
-    const Point& first() const
+    const BasicPoint<T>& first() const
     {
         if (p.x <= q.x)
             return p;
@@ -27,7 +28,7 @@ struct Segment
             return q;
     }
 
-    const Point& second() const
+    const BasicPoint<T>& second() const
     {
         if (p.x <= q.x)
             return q;
@@ -35,23 +36,25 @@ struct Segment
             return p;
     }
 
-    bool operator< (const Segment& other) const
+    bool operator< (const BasicSegment& other) const
     {
         return value > other.value;
     }
 
-    bool operator> (const Segment& other) const
+    bool operator> (const BasicSegment& other) const
     {
         return value < other.value;
     }
 
-    bool operator== (const Segment& other) const
+    bool operator== (const BasicSegment& other) const
     {
         return value == other.value;
     }
 
     void calculateValue(double x_)
     {
-        value = ((second().y - first().y) / (second().x - first().x)) * (x_ - first().x) + first().y;
+        value = ((double(second().y) - first().y) / (double(second().x) - first().x)) * (x_ - first().x) + first().y;
     }
 };
+
+using Segment = BasicSegment<double>;
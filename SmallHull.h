@@ -0,0 +1,172 @@
+#pragma once
+
+#include "Point.h"
+#include "Util.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Hull kernels for sets of at most SmallHullMax points, with the size as a
+// template parameter. The points are sorted by a Batcher odd-even merge
+// network generated at compile time and both chains of the monotone chain
+// are unrolled point by point, so the only data-dependent branches left are
+// the pops. Duplicates need no pass of their own: a repeated point makes a
+// collinear turn and is popped.
+
+constexpr int SmallHullMax = 16;
+
+struct SortingNetwork
+{
+    int size = 0;
+    int first[64] = {};
+    int second[64] = {};
+};
+
+// Batcher's network for the next power of two, without the comparators that
+// touch the padding: those would only ever compare against +infinity.
+constexpr SortingNetwork oddEvenMergeNetwork(int n)
+{
+    SortingNetwork network;
+
+    int padded = 1;
+    while (padded < n)
+        padded *= 2;
+
+    for (int p = 1; p < padded; p *= 2)
+        for (int k = p; k >= 1; k /= 2)
+            for (int j = k % p; j + k < padded; j += 2 * k)
+                for (int i = 0; i < k && i + j + k < padded; ++i)
+                    if ((i + j) / (2 * p) == (i + j + k) / (2 * p) && i + j + k < n)
+                    {
+                        network.first[network.size] = i + j;
+                        network.second[network.size] = i + j + k;
+                        ++network.size;
+                    }
+
+    return network;
+}
+
+template <int N>
+struct SmallSort
+{
+    static constexpr SortingNetwork network = oddEvenMergeNetwork(N);
+};
+
+// Coordinates are kept in two arrays so the selects stay on scalars.
+template <typename T>
+inline void compareExchange(T* xs, T* ys, int i, int j)
+{
+    T ax = xs[i], ay = ys[i], bx = xs[j], by = ys[j];
+    bool swap = (bx < ax) | ((bx == ax) & (by < ay));
+
+    xs[i] = swap ? bx : ax;
+    ys[i] = swap ? by : ay;
+    xs[j] = swap ? ax : bx;
+    ys[j] = swap ? ay : by;
+}
+
+template <int N, typename T, std::size_t... I>
+inline void sortSmall(T* xs, T* ys, std::index_sequence<I...>)
+{
+    constexpr const SortingNetwork& network = SmallSort<N>::network;
+    (compareExchange(xs, ys, network.first[I], network.second[I]), ...);
+}
+
+// One monotone chain step; the chain below top is fixed.
+template <typename T>
+inline void chainStep(BasicPoint<T>* chain, int& k, int top, const BasicPoint<T>& p)
+{
+    while (k >= top && orientation(chain[k - 2], chain[k - 1], p) != CW)
+        --k;
+    chain[k++] = p;
+}
+
+template <int N, typename T, std::size_t... Upper, std::size_t... Lower>
+inline int smallChain(const T* xs, const T* ys, BasicPoint<T>* ring, std::index_sequence<Upper...>, std::index_sequence<Lower...>)
+{
+    int k = 0;
+    (chainStep(ring, k, 2, BasicPoint<T>{xs[Upper], ys[Upper]}), ...);
+
+    int top = k + 1;
+    (chainStep(ring, k, top, BasicPoint<T>{xs[N - 2 - int(Lower)], ys[N - 2 - int(Lower)]}), ...);
+
+    return k;
+}
+
+// Hull of exactly N points as a clockwise closed ring from the lowest leftmost
+// vertex. ring needs room for 2 * N points; returns the ring length.
+template <int N, typename T>
+int smallConvexHull(const BasicPoint<T>* points, BasicPoint<T>* ring)
+{
+    // neither a network nor a lower chain
+    if constexpr (N == 1)
+    {
+        ring[0] = ring[1] = points[0];
+        return 2;
+    }
+    else
+    {
+        T xs[N], ys[N];
+        for (int i = 0; i < N; ++i)
+        {
+            xs[i] = points[i].x;
+            ys[i] = points[i].y;
+        }
+
+        sortSmall<N>(xs, ys, std::make_index_sequence<SmallSort<N>::network.size>{});
+
+        if (xs[0] == xs[N - 1] && ys[0] == ys[N - 1])
+        {
+            ring[0] = ring[1] = {xs[0], ys[0]};
+            return 2;
+        }
+
+        return smallChain<N>(xs, ys, ring, std::make_index_sequence<N>{}, std::make_index_sequence<N - 1>{});
+    }
+}
+
+template <typename T, std::size_t... N>
+int smallConvexHull(const BasicPoint<T>* points, int n, BasicPoint<T>* ring, std::index_sequence<N...>)
+{
+    int k = 0;
+    ((n == int(N) + 1 && (k = smallConvexHull<int(N) + 1>(points, ring), true)) || ...);
+
+    return k;
+}
+
+// Same for 0 <= n <= SmallHullMax picked at run time; an empty set gives an
+// empty ring.
+template <typename T>
+int smallConvexHull(const BasicPoint<T>* points, int n, BasicPoint<T>* ring)
+{
+    return smallConvexHull(points, n, ring, std::make_index_sequence<SmallHullMax>{});
+}
+
+// The hull in the format of the hull functions: a closed clockwise ring
+// rotated by rotateClockwiseRing.
+template <typename T>
+void smallConvexHull(const std::vector<BasicPoint<T>>& points, std::vector<BasicPoint<T>>& output)
+{
+    BasicPoint<T> ring[2 * SmallHullMax];
+    int k = smallConvexHull(points.data(), points.size(), ring);
+
+    output.clear();
+    if (k == 0)
+        return;
+
+    rotateClockwiseRing(ring, k - 1);
+
+    output.assign(ring, ring + k - 1);
+    output.push_back(output.front());
+}
+
+template <typename T>
+std::vector<BasicPoint<T>> smallConvexHull(const std::vector<BasicPoint<T>>& points)
+{
+    std::vector<BasicPoint<T>> output;
+    smallConvexHull(points, output);
+
+    return output;
+}
@@ -0,0 +1,167 @@
+#pragma once
+
+#include "Trace.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Hot path counters, compiled in with -DGEOMETRY_STATS. Without it the
+// STATS_ macros expand to nothing and stats() stays all zeros.
+// STATS_PHASE() and STATS_NEXT_PHASE() time named phases for both the stats
+// and the trace.
+//
+// Counters are per thread: resetStats() before a call, stats() after it. The
+// pool adds what its workers counted for a par call to the caller's.
+struct Stats
+{
+    // predicates
+    long long orientationCalls = 0;
+    long long intersectionCalls = 0;
+
+    // AVLTree
+    long long treeRotations = 0;
+    long long treeAllocations = 0;
+    int treeMaxHeight = 0;
+
+    // sweeps: events handled per type, and popped events that were outdated
+    long long startEvents = 0;
+    long long endEvents = 0;
+    long long crossEvents = 0;
+    long long siteEvents = 0;
+    long long circleEvents = 0;
+    long long staleEvents = 0;
+
+    // wall time per phase in seconds, in order of first use
+    std::vector<std::pair<std::string, double>> phases;
+
+    void addPhase(const char* name, double seconds)
+    {
+        auto it = std::find_if(phases.begin(), phases.end(), [name](const auto& phase) {
+            return phase.first == name;
+        });
+
+        if (it == phases.end())
+            phases.emplace_back(name, seconds);
+        else
+            it->second += seconds;
+    }
+
+    // Adds the counters of a worker's share of a parallel call. Its phases
+    // overlap the caller's and are left out.
+    void addCounters(const Stats& other)
+    {
+        orientationCalls += other.orientationCalls;
+        intersectionCalls += other.intersectionCalls;
+        treeRotations += other.treeRotations;
+        treeAllocations += other.treeAllocations;
+        treeMaxHeight = std::max(treeMaxHeight, other.treeMaxHeight);
+        startEvents += other.startEvents;
+        endEvents += other.endEvents;
+        crossEvents += other.crossEvents;
+        siteEvents += other.siteEvents;
+        circleEvents += other.circleEvents;
+        staleEvents += other.staleEvents;
+    }
+
+    void writeJson(std::ostream& os) const
+    {
+        os << "{\n";
+
+        const std::pair<const char*, long long> counters[] = {
+            {"orientationCalls", orientationCalls},
+            {"intersectionCalls", intersectionCalls},
+            {"treeRotations", treeRotations},
+            {"treeAllocations", treeAllocations},
+            {"treeMaxHeight", treeMaxHeight},
+            {"startEvents", startEvents},
+            {"endEvents", endEvents},
+            {"crossEvents", crossEvents},
+            {"siteEvents", siteEvents},
+            {"circleEvents", circleEvents},
+            {"staleEvents", staleEvents}
+        };
+
+        for (const auto& counter : counters)
+            os << "  \"" << counter.first << "\": " << counter.second << ",\n";
+
+        os << "  \"phaseSeconds\": {";
+        for (size_t i = 0; i < phases.size(); ++i)
+            os << (i ? ", " : "") << "\"" << phases[i].first << "\": " << phases[i].second;
+        os << "}\n}\n";
+    }
+};
+
+inline Stats& stats()
+{
+    thread_local Stats threadStats;
+    return threadStats;
+}
+
+inline void resetStats()
+{
+    stats() = Stats();
+}
+
+// Adds the time from construction, or the last next(), to the current phase;
+// with GEOMETRY_TRACE the phase is also recorded as a trace span.
+class ScopedPhase
+{
+public:
+    explicit ScopedPhase(const char* name) :
+        m_name(name),
+        m_begin(traceNow())
+    {
+    }
+
+    ~ScopedPhase()
+    {
+        stop();
+    }
+
+    void next(const char* name)
+    {
+        stop();
+
+        m_name = name;
+        m_begin = traceNow();
+    }
+
+private:
+    void stop()
+    {
+#if defined(GEOMETRY_STATS) || defined(GEOMETRY_TRACE)
+        int64_t end = traceNow();
+#endif
+
+#ifdef GEOMETRY_STATS
+        stats().addPhase(m_name, (end - m_begin) * 1e-9);
+#endif
+#ifdef GEOMETRY_TRACE
+        threadTraceBuffer().record(m_name, m_begin, end);
+#endif
+    }
+
+private:
+    const char* m_name;
+    int64_t m_begin;
+};
+
+#ifdef GEOMETRY_STATS
+#define STATS_COUNT(counter) (++stats().counter)
+#define STATS_MAX(counter, value) (stats().counter = std::max<long long>(stats().counter, (value)))
+#else
+#define STATS_COUNT(counter) ((void)0)
+#define STATS_MAX(counter, value) ((void)0)
+#endif
+
+#if defined(GEOMETRY_STATS) || defined(GEOMETRY_TRACE)
+#define STATS_PHASE(name) ScopedPhase statsPhase(name)
+#define STATS_NEXT_PHASE(name) statsPhase.next(name)
+#else
+#define STATS_PHASE(name) ((void)0)
+#define STATS_NEXT_PHASE(name) ((void)0)
+#endif
@@ -0,0 +1,212 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ios>
+#include <ostream>
+
+// Timelines in the Chrome trace format (chrome://tracing, Perfetto), compiled
+// in with -DGEOMETRY_TRACE. Without it TRACE_SPAN expands to nothing.
+//
+// Every thread writes the spans it closes to its own ring buffer: the owner
+// is the only writer and publishes a span with a release store of the count,
+// so recording never takes a lock. A full buffer overwrites its oldest spans.
+// Buffers are pushed onto a global list with a CAS on the first span of a
+// thread and outlive it, so spans of joined workers are still written out.
+// A thread hands its buffer back when it exits and the next new thread takes
+// it over, so there are only as many buffers as threads ever traced at once;
+// a track then holds threads that did not overlap. Write or reset the trace
+// while no traced work is running.
+
+struct TraceSpan
+{
+    const char* name;
+
+    // nanoseconds since the first traceNow()
+    int64_t begin;
+    int64_t end;
+};
+
+class TraceBuffer
+{
+public:
+    static constexpr int Capacity = 1 << 14;
+
+    explicit TraceBuffer(int tid) :
+        m_tid(tid)
+    {
+    }
+
+    void record(const char* name, int64_t begin, int64_t end)
+    {
+        uint64_t count = m_count.load(std::memory_order_relaxed);
+        m_spans[count % Capacity] = {name, begin, end};
+        m_count.store(count + 1, std::memory_order_release);
+    }
+
+    uint64_t count() const
+    {
+        return m_count.load(std::memory_order_acquire);
+    }
+
+    const TraceSpan& span(uint64_t i) const
+    {
+        return m_spans[i % Capacity];
+    }
+
+    void clear()
+    {
+        m_count.store(0, std::memory_order_release);
+    }
+
+    int tid() const
+    {
+        return m_tid;
+    }
+
+    // Claims a buffer handed back by its thread.
+    bool tryAcquire()
+    {
+        bool inUse = false;
+        return m_inUse.compare_exchange_strong(inUse, true, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+
+    void release()
+    {
+        m_inUse.store(false, std::memory_order_release);
+    }
+
+    TraceBuffer* next = nullptr;
+
+private:
+    int m_tid;
+    std::atomic<bool> m_inUse{true};
+    std::atomic<uint64_t> m_count{0};
+    TraceSpan m_spans[Capacity];
+};
+
+inline int64_t traceNow()
+{
+    static const auto epoch = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+inline std::atomic<TraceBuffer*>& traceBuffers()
+{
+    static std::atomic<TraceBuffer*> head{nullptr};
+    return head;
+}
+
+inline TraceBuffer* acquireTraceBuffer()
+{
+    static std::atomic<int> nextTid{1};
+
+    auto& head = traceBuffers();
+    for (auto* b = head.load(std::memory_order_acquire); b; b = b->next)
+        if (b->tryAcquire())
+            return b;
+
+    auto* b = new TraceBuffer(nextTid.fetch_add(1, std::memory_order_relaxed));
+
+    b->next = head.load(std::memory_order_relaxed);
+    while (!head.compare_exchange_weak(b->next, b, std::memory_order_release, std::memory_order_relaxed))
+        ;
+
+    return b;
+}
+
+// Hands the buffer of a thread back when the thread exits.
+struct TraceBufferLease
+{
+    TraceBuffer* buffer;
+
+    ~TraceBufferLease()
+    {
+        buffer->release();
+    }
+};
+
+inline TraceBuffer& threadTraceBuffer()
+{
+    thread_local TraceBufferLease lease{acquireTraceBuffer()};
+    return *lease.buffer;
+}
+
+inline void resetTrace()
+{
+    for (auto* b = traceBuffers().load(std::memory_order_acquire); b; b = b->next)
+        b->clear();
+}
+
+// Complete ("X") events, one track per thread.
+inline void writeChromeTrace(std::ostream& os)
+{
+    auto flags = os.flags();
+    auto precision = os.precision();
+    os.setf(std::ios::fixed, std::ios::floatfield);
+    os.precision(3);
+
+    os << "{\"traceEvents\": [";
+
+    bool first = true;
+    for (auto* b = traceBuffers().load(std::memory_order_acquire); b; b = b->next)
+    {
+        uint64_t count = b->count();
+        for (uint64_t i = count > TraceBuffer::Capacity ? count - TraceBuffer::Capacity : 0; i < count; ++i)
+        {
+            const auto& s = b->span(i);
+
+            os << (first ? "\n" : ",\n");
+            os << "{\"name\": \"" << s.name << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << b->tid()
+               << ", \"ts\": " << s.begin * 1e-3 << ", \"dur\": " << (s.end - s.begin) * 1e-3 << "}";
+
+            first = false;
+        }
+    }
+
+    os << "\n], \"displayTimeUnit\": \"ms\"}\n";
+
+    os.flags(flags);
+    os.precision(precision);
+}
+
+// Records the time from construction, or the last next(), as a span.
+class ScopedTrace
+{
+public:
+    explicit ScopedTrace(const char* name) :
+        m_name(name),
+        m_begin(traceNow())
+    {
+    }
+
+    ~ScopedTrace()
+    {
+        stop();
+    }
+
+    void next(const char* name)
+    {
+        stop();
+
+        m_name = name;
+        m_begin = traceNow();
+    }
+
+private:
+    void stop()
+    {
+        threadTraceBuffer().record(m_name, m_begin, traceNow());
+    }
+
+private:
+    const char* m_name;
+    int64_t m_begin;
+};
+
+#ifdef GEOMETRY_TRACE
+#define TRACE_SPAN(name) ScopedTrace traceSpan(name)
+#else
+#define TRACE_SPAN(name) ((void)0)
+#endif
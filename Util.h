@@ -2,11 +2,14 @@
 
 #include "Point.h"
 #include "Segment.h"
+#include "Stats.h"
+#include "Execution.h"
 
 #include <vector>
 #include <algorithm>
 #include <numeric>
 #include <cmath>
+#include <random>
 #include <iostream>
 
 
@@ -17,79 +20,319 @@ enum eOrientation
     CCW
 };
 
-eOrientation orientation(const Point& p, const Point& q, const Point& r)
+// Exact on integer coordinates, see ScalarTraits.
+template <typename T>
+eOrientation orientation(const BasicPoint<T>& p, const BasicPoint<T>& q, const BasicPoint<T>& r)
 {
-    double val = (q.y - p.y) * (r.x - q.x) - (q.x - p.x) * (r.y - q.y);
-    if (val == 0.) return COLINEAR;  // Collinear
-    return (val > 0.) ? CW : CCW; // Clockwise or Counterclockwise
+    using Exact = typename ScalarTraits<T>::Exact;
+
+    STATS_COUNT(orientationCalls);
+
+    Exact val = (Exact(q.y) - p.y) * (Exact(r.x) - q.x) - (Exact(q.x) - p.x) * (Exact(r.y) - q.y);
+    if (val == 0) return COLINEAR;  // Collinear
+    return (val > 0) ? CW : CCW; // Clockwise or Counterclockwise
 }
 
-void sortPolygonInClockwiseOrder(std::vector<Point>& polygon)
+template <typename T>
+void sortPolygonInClockwiseOrder(std::vector<BasicPoint<T>>& polygon)
 {
     using namespace std;
 
-    const auto center = reduce(polygon.begin(), polygon.end(), Point(), std::plus<Point>()) / polygon.size();
+    // in double so that integer coordinates neither overflow nor truncate
+    Point center{};
+    for (const auto& p : polygon)
+        center = center + Point{double(p.x), double(p.y)};
+    center = center / polygon.size();
 
-    sort(polygon.begin(), polygon.end(), [&center](const Point& p1, const Point& p2) {
+    sort(polygon.begin(), polygon.end(), [&center](const BasicPoint<T>& p1, const BasicPoint<T>& p2) {
         return atan2(p1.y - center.y, p1.x - center.x) > atan2(p2.y - center.y, p2.x - center.x);
     });
 }
 
-void lexicographicSort(std::vector<Point>& points)
+// Rotates a clockwise convex ring of h distinct vertices, without the repeated
+// front, to where sortPolygonInClockwiseOrder would start it: the vertex with
+// the largest angle around the centroid. Graham's scan and the small set
+// kernels both finish with this, so their rings are the same.
+template <typename T>
+void rotateClockwiseRing(BasicPoint<T>* ring, int h)
 {
     using namespace std;
 
-    sort(points.begin(), points.end(), [](const Point& p1, const Point& p2) {
-        if (p1.x < p2.x)
-            return true;
-        else if (p1.x == p2.x)
-            return p1.y < p2.y;
-        
-        return false;
+    double cx = 0., cy = 0.;
+    for (int i = 0; i < h; ++i)
+    {
+        cx += ring[i].x;
+        cy += ring[i].y;
+    }
+    cx /= h;
+    cy /= h;
+
+    int start = 0;
+    double startAngle = -M_PI - 1.;
+    for (int i = 0; i < h; ++i)
+    {
+        double angle = atan2(ring[i].y - cy, ring[i].x - cx);
+        if (angle > startAngle)
+        {
+            start = i;
+            startAngle = angle;
+        }
+    }
+
+    rotate(ring, ring + start, ring + h);
+}
+
+// By x, then by y.
+template <typename T>
+bool lexicographicLess(const BasicPoint<T>& p1, const BasicPoint<T>& p2)
+{
+    return p1.x < p2.x || (p1.x == p2.x && p1.y < p2.y);
+}
+
+// Exact, unlike the == of floating point points.
+template <typename T>
+bool samePoint(const BasicPoint<T>& p1, const BasicPoint<T>& p2)
+{
+    return p1.x == p2.x && p1.y == p2.y;
+}
+
+template <typename T>
+void lexicographicSort(std::vector<BasicPoint<T>>& points)
+{
+    std::sort(points.begin(), points.end(), lexicographicLess<T>);
+}
+
+template <typename T>
+void lexicographicSort(const SequencedPolicy&, std::vector<BasicPoint<T>>& points)
+{
+    lexicographicSort(points);
+}
+
+// Sorts parts on the pool, then merges neighbouring parts in rounds. Points
+// comparing equal are equal, so the order is the sequential one.
+template <typename T>
+void lexicographicSort(const ParallelPolicy&, std::vector<BasicPoint<T>>& points)
+{
+    using namespace std;
+
+    auto& pool = threadPool();
+    int parts = min<int>(pool.size(), points.size() / ParallelGrain);
+    if (parts < 2)
+    {
+        lexicographicSort(points);
+        return;
+    }
+
+    auto bounds = splitRange(points.size(), parts);
+    auto at = [&](int k) {
+        return points.begin() + bounds[k];
+    };
+
+    pool.run(parts, [&](int k) {
+        sort(at(k), at(k + 1), lexicographicLess<T>);
     });
+
+    for (int width = 1; width < parts; width *= 2)
+    {
+        pool.run((parts + 2 * width - 1) / (2 * width), [&](int m) {
+            int first = 2 * m * width;
+            int middle = min(first + width, parts), last = min(first + 2 * width, parts);
+            inplace_merge(at(first), at(middle), at(last), lexicographicLess<T>);
+        });
+    }
 }
 
-void sortByPolarAngle(std::vector<Point>& points)
+// Turns the output of the convex hull functions (clockwise closed ring) or any
+// convex ring into its strictly convex vertices in counter-clockwise order,
+// without the repeated front. Collinear input collapses to its two extremes.
+template <typename T>
+std::vector<BasicPoint<T>> normalizeConvexPolygon(const std::vector<BasicPoint<T>>& hull)
 {
     using namespace std;
 
-    auto min = min_element(points.begin(), points.end(), [](const Point& p1, const Point& p2) {
-        if (p1.x < p2.x)
-            return true;
-        else if (p1.x == p2.x)
-            return p1.y < p2.y;
-        
+    vector<BasicPoint<T>> polygon;
+    for (const auto& p : hull)
+        if (polygon.empty() || !samePoint(p, polygon.back()))
+            polygon.push_back(p);
+
+    while (polygon.size() > 1 && samePoint(polygon.back(), polygon.front()))
+        polygon.pop_back();
+
+    typename ScalarTraits<T>::Exact area = 0;
+    for (int i = 0; i < polygon.size(); ++i)
+        area += polygon[i] ^ polygon[(i + 1) % polygon.size()];
+
+    if (area < 0)
+        reverse(polygon.begin(), polygon.end());
+
+    // drop vertices in the middle of an edge
+    vector<BasicPoint<T>> vertices;
+    for (int i = 0; i < polygon.size(); ++i)
+    {
+        const auto& prev = polygon[(i + polygon.size() - 1) % polygon.size()];
+        const auto& next = polygon[(i + 1) % polygon.size()];
+
+        if (polygon.size() < 3 || orientation(prev, polygon[i], next) != COLINEAR)
+            vertices.push_back(polygon[i]);
+    }
+
+    if (vertices.size() < 3 && polygon.size() >= 2)
+    {
+        auto extremes = minmax_element(polygon.begin(), polygon.end(), lexicographicLess<T>);
+        vertices = {*extremes.first, *extremes.second};
+    }
+
+    return vertices;
+}
+
+// n random points of the ellipse with radii rx and ry around (1, -0.5), in
+// the format the hull functions return. For tests.
+template <typename Generator>
+std::vector<Point> randomConvexPolygon(Generator& gen, int n, double rx = 3., double ry = 2.)
+{
+    std::uniform_real_distribution<double> unit(0., 1.);
+
+    std::vector<Point> polygon(n);
+    for (auto& p : polygon)
+    {
+        double a = unit(gen) * 2. * M_PI;
+        p = {rx * std::cos(a) + 1., ry * std::sin(a) - 0.5};
+    }
+
+    sortPolygonInClockwiseOrder(polygon);
+    polygon.push_back(polygon.front());
+
+    return polygon;
+}
+
+// For tests: whether ring is a clockwise closed ring of points of
+// [first, last) without collinear vertices. With enclosing also whether no
+// point is outside of it, which makes it their hull.
+template <typename T>
+bool isConvexRingOf(const BasicPoint<T>* first, const BasicPoint<T>* last, const std::vector<BasicPoint<T>>& ring, bool enclosing = true)
+{
+    using namespace std;
+
+    if (ring.size() < 2 || !samePoint(ring.front(), ring.back()))
         return false;
-    });
+
+    int n = ring.size() - 1;
+    for (int j = 0; j < n; ++j)
+    {
+        if (n > 2 && orientation(ring[j], ring[j + 1], ring[(j + 2) % n]) != CW)
+            return false;
+
+        if (none_of(first, last, [&](const BasicPoint<T>& p) { return samePoint(p, ring[j]); }))
+            return false;
+
+        if (enclosing && any_of(first, last, [&](const BasicPoint<T>& p) { return orientation(ring[j], ring[j + 1], p) == CCW; }))
+            return false;
+    }
+
+    // a point or a segment: the edges do not bound the ends
+    if (enclosing && n <= 2)
+    {
+        auto extremes = minmax_element(ring.begin(), ring.end() - 1, lexicographicLess<T>);
+        return none_of(first, last, [&](const BasicPoint<T>& p) {
+            return lexicographicLess(p, *extremes.first) || lexicographicLess(*extremes.second, p);
+        });
+    }
+
+    return true;
+}
+
+// Monotone chain over sorted, distinct points: the upper chain left to right,
+// then the lower one back, keeping clockwise turns only. chain needs room for
+// 2 * m points; returns the length of the closed ring written to it.
+template <typename T>
+int monotoneChain(const BasicPoint<T>* sorted, int m, BasicPoint<T>* chain)
+{
+    int k = 0;
+    for (int i = 0; i < m; ++i)
+    {
+        while (k >= 2 && orientation(chain[k - 2], chain[k - 1], sorted[i]) != CW)
+            --k;
+        chain[k++] = sorted[i];
+    }
+
+    for (int i = m - 2, top = k + 1; i >= 0; --i)
+    {
+        while (k >= top && orientation(chain[k - 2], chain[k - 1], sorted[i]) != CW)
+            --k;
+        chain[k++] = sorted[i];
+    }
+
+    if (m == 1)
+        chain[k++] = sorted[0];
+
+    return k;
+}
+
+// Hull of any n points by the monotone chain, as a clockwise closed ring from
+// the leftmost, lowest point: sorts points in place and drops duplicates.
+// chain needs room for 2 * n points; returns the ring length, 0 for none.
+template <typename T>
+int monotoneChainHull(BasicPoint<T>* points, int n, BasicPoint<T>* chain)
+{
+    std::sort(points, points + n, lexicographicLess<T>);
+    int m = std::unique(points, points + n, samePoint<T>) - points;
+
+    return monotoneChain(points, m, chain);
+}
+
+template <typename T>
+void sortByPolarAngle(std::vector<BasicPoint<T>>& points)
+{
+    using namespace std;
+
+    auto min = min_element(points.begin(), points.end(), lexicographicLess<T>);
 
     cout << "min = " << min->x << ", " << min->y << endl;
 
-    sort(points.begin(), points.end(), [&min](const Point& p1, const Point& p2) {
-        return atan2(p1.y - min->y, p1.x - min->x) > atan2(p2.y - min->y, p2.x - min->x);
+    sort(points.begin(), points.end(), [&min](const BasicPoint<T>& p1, const BasicPoint<T>& p2) {
+        return atan2(double(p1.y) - min->y, double(p1.x) - min->x) > atan2(double(p2.y) - min->y, double(p2.x) - min->x);
     });
 }
 
 // https://stackoverflow.com/questions/563198/how-do-you-detect-where-two-line-segments-intersect
 // overlapping case is not handled
-bool intersection(const Segment& l1, const Segment& l2, Point& i)
+template <typename T>
+bool intersection(const BasicSegment<T>& l1, const BasicSegment<T>& l2, BasicPoint<T>& i)
 {
     using namespace std;
 
-    Point s1 = l1.q - l1.p;
-    Point s2 = l2.q - l2.p;
+    STATS_COUNT(intersectionCalls);
+
+    // integer coordinates decide exactly, only the point is rounded
+    if constexpr (is_integral_v<T>)
+    {
+        if (orientation(l1.p, l1.q, l2.p) == orientation(l1.p, l1.q, l2.q) ||
+            orientation(l2.p, l2.q, l1.p) == orientation(l2.p, l2.q, l1.q))
+            return false;
+    }
+
+    double s1x = double(l1.q.x) - l1.p.x, s1y = double(l1.q.y) - l1.p.y;
+    double s2x = double(l2.q.x) - l2.p.x, s2y = double(l2.q.y) - l2.p.y;
+    double dx = double(l1.p.x) - l2.p.x, dy = double(l1.p.y) - l2.p.y;
 
     double s, t;
     // s = s1 ^ (l1.p - l2.p) / (s1 ^ s2);
-    s = (-s1.y * (l1.p.x - l2.p.x) + s1.x * (l1.p.y - l2.p.y)) / (-s2.x * s1.y + s1.x * s2.y);
+    s = (-s1y * dx + s1x * dy) / (-s2x * s1y + s1x * s2y);
     // t = s2 ^ (l1.p - l2.p) / (s1 ^ s2);
-    t = ( s2.x * (l1.p.y - l2.p.y) - s2.y * (l1.p.x - l2.p.x)) / (-s2.x * s1.y + s1.x * s2.y);
+    t = ( s2x * dy - s2y * dx) / (-s2x * s1y + s1x * s2y);
 
     // cout << s << " " << t << endl;
 
-    if ((s >= 0 && s <= 1) && (t >= 0 && t <= 1))
+    if (is_integral_v<T> || ((s >= 0 && s <= 1) && (t >= 0 && t <= 1)))
     {
         // Collision detected
-        i = l1.p + s1 * t;
+        double x = l1.p.x + s1x * t;
+        double y = l1.p.y + s1y * t;
+
+        if constexpr (is_integral_v<T>)
+            i = {T(llround(x)), T(llround(y))};
+        else
+            i = {T(x), T(y)};
 
         return true;
     }
@@ -0,0 +1,650 @@
+#include "Point.h"
+#include "Util.h"
+
+#include <vector>
+#include <queue>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <cstdint>
+
+#include <gtest/gtest.h>
+
+
+using namespace std;
+
+struct VoronoiDiagram
+{
+    struct HalfEdge
+    {
+        // the cell on the left of the half-edge
+        int site;
+
+        // vertex index, -1 at infinity; the destination is the origin of the twin
+        int origin;
+
+        int twin;
+
+        // next half-edge counter-clockwise around the cell, -1 when this one runs off to infinity
+        int next;
+    };
+
+    vector<Point> vertices;
+    vector<HalfEdge> halfEdges;
+
+    // one half-edge per site, for unbounded cells the one coming in from
+    // infinity; -1 for a site repeating an earlier one
+    vector<int> cells;
+};
+
+// x of the breakpoint with the arc of l on its left and the arc of r on its
+// right when the sweep line is at y = sweep.
+double breakpoint(const Point& l, const Point& r, double sweep)
+{
+    double dl = 2. * (l.y - sweep);
+    double dr = 2. * (r.y - sweep);
+
+    // sites on the sweep line have degenerate, vertical arcs
+    if (dl == 0. && dr == 0.)
+        return (l.x + r.x) / 2.;
+    if (dl == 0.)
+        return l.x;
+    if (dr == 0.)
+        return r.x;
+
+    // the parabolas differ by a * x^2 + b * x + c, which goes from negative
+    // to positive at the breakpoint; solved in the cancellation-free form
+    double a = 1. / dl - 1. / dr;
+    double b = -2. * (l.x / dl - r.x / dr);
+    double c = (l.x * l.x + l.y * l.y - sweep * sweep) / dl - (r.x * r.x + r.y * r.y - sweep * sweep) / dr;
+
+    double root = sqrt(max(0., b * b - 4. * a * c));
+
+    if (b < 0.)
+        return a != 0. ? (-b + root) / (2. * a) : -c / b;
+
+    return 2. * c / (-b - root);
+}
+
+// Fortune's sweep. The line moves downwards; the beach line is an
+// arena-backed treap of arcs threaded into a doubly linked list, so site
+// events locate their arc in O(log n) by evaluating breakpoints on the way
+// down and circle events unlink an arc without any search. Circle events sit
+// in a binary heap and are invalidated lazily: an arc remembers the id of its
+// pending event and anything else popped for it is stale.
+class FortuneSweep
+{
+public:
+    explicit FortuneSweep(const vector<Point>& sites);
+
+    void run(VoronoiDiagram& out);
+
+private:
+    struct Arc
+    {
+        int site;
+
+        int left, right, parent;
+        uint32_t priority;
+
+        int prev, next;
+
+        // half-edge traced by the breakpoint between this arc and the next
+        int edge;
+
+        // id of the pending circle event, -1 if none
+        int event;
+    };
+
+    struct CircleEvent
+    {
+        double y;
+        Point center;
+        int arc;
+        int id;
+
+        bool operator< (const CircleEvent& e) const
+        {
+            return y < e.y || (y == e.y && center.x > e.center.x);
+        }
+    };
+
+    void siteEvent(int site);
+
+    void circleEvent(const CircleEvent& event);
+
+    void checkCircle(int arc, double sweep);
+
+    int locate(const Point& p) const;
+
+    int newArc(int site);
+
+    void insertAfter(int arc, int newArc);
+
+    void erase(int arc);
+
+    void rotateUp(int arc);
+
+    // Twin half-edges of a new Voronoi edge; the returned one belongs to the
+    // cell of siteLeft, its twin to the cell of siteRight.
+    int newEdge(int siteLeft, int siteRight);
+
+    void link(VoronoiDiagram& out);
+
+private:
+    const vector<Point>& m_sites;
+
+    vector<Arc> m_arcs;
+    vector<int> m_freeArcs;
+    int m_root = -1;
+    int m_tail = -1;
+
+    priority_queue<CircleEvent> m_events;
+    int m_eventCount = 0;
+
+    uint32_t m_random = 2463534242u;
+
+    double m_topRow = 0.;
+
+    VoronoiDiagram* m_out = nullptr;
+};
+
+FortuneSweep::FortuneSweep(const vector<Point>& sites) :
+    m_sites(sites)
+{
+    m_arcs.reserve(2 * sites.size());
+}
+
+void FortuneSweep::run(VoronoiDiagram& out)
+{
+    m_out = &out;
+
+    out.vertices.clear();
+    out.halfEdges.clear();
+    out.cells.assign(m_sites.size(), -1);
+
+    out.vertices.reserve(2 * m_sites.size());
+    out.halfEdges.reserve(6 * m_sites.size());
+
+    STATS_PHASE("sort");
+
+    vector<int> order(m_sites.size());
+    iota(order.begin(), order.end(), 0);
+
+    sort(order.begin(), order.end(), [this](int a, int b) {
+        const auto& p = m_sites[a];
+        const auto& q = m_sites[b];
+        return p.y > q.y || (p.y == q.y && (p.x < q.x || (p.x == q.x && a < b)));
+    });
+
+    order.erase(unique(order.begin(), order.end(), [this](int a, int b) {
+        return m_sites[a].x == m_sites[b].x && m_sites[a].y == m_sites[b].y;
+    }), order.end());
+
+    if (order.empty())
+        return;
+
+    STATS_NEXT_PHASE("sweep");
+
+    m_topRow = m_sites[order[0]].y;
+    m_root = m_tail = newArc(order[0]);
+
+    for (int i = 1; i < order.size() || !m_events.empty();)
+    {
+        if (!m_events.empty() && (i == order.size() || m_events.top().y >= m_sites[order[i]].y))
+        {
+            auto event = m_events.top();
+            m_events.pop();
+
+            if (m_arcs[event.arc].event == event.id)
+            {
+                STATS_COUNT(circleEvents);
+                circleEvent(event);
+            }
+            else
+            {
+                STATS_COUNT(staleEvents);
+            }
+        }
+        else
+        {
+            STATS_COUNT(siteEvents);
+            siteEvent(order[i++]);
+        }
+    }
+
+    STATS_NEXT_PHASE("link");
+    link(out);
+}
+
+void FortuneSweep::siteEvent(int site)
+{
+    const auto& p = m_sites[site];
+
+    if (p.y == m_topRow)
+    {
+        // still on the first row: the new arc just extends the beach line to the right
+        int arc = newArc(site);
+        m_arcs[m_tail].edge = newEdge(site, m_arcs[m_tail].site);
+        insertAfter(m_tail, arc);
+        return;
+    }
+
+    int arc = locate(p);
+    int site0 = m_arcs[arc].site;
+
+    // the arc is split in two around the new one; both breakpoints trace the same edge
+    int middle = newArc(site);
+    int right = newArc(site0);
+
+    insertAfter(arc, middle);
+    insertAfter(middle, right);
+
+    m_arcs[right].edge = m_arcs[arc].edge;
+    m_arcs[arc].edge = newEdge(site, site0);
+    m_arcs[middle].edge = m_out->halfEdges[m_arcs[arc].edge].twin;
+
+    m_arcs[arc].event = -1;
+
+    checkCircle(arc, p.y);
+    checkCircle(right, p.y);
+}
+
+void FortuneSweep::circleEvent(const CircleEvent& event)
+{
+    auto& halfEdges = m_out->halfEdges;
+
+    int arc = event.arc;
+    int prev = m_arcs[arc].prev;
+    int next = m_arcs[arc].next;
+
+    int vertex = m_out->vertices.size();
+    m_out->vertices.push_back(event.center);
+
+    // both breakpoints around the vanishing arc end here, a new one starts
+    halfEdges[halfEdges[m_arcs[prev].edge].twin].origin = vertex;
+    halfEdges[halfEdges[m_arcs[arc].edge].twin].origin = vertex;
+
+    m_arcs[prev].edge = newEdge(m_arcs[next].site, m_arcs[prev].site);
+    halfEdges[m_arcs[prev].edge].origin = vertex;
+
+    erase(arc);
+
+    m_arcs[prev].event = -1;
+    m_arcs[next].event = -1;
+
+    checkCircle(prev, event.y);
+    checkCircle(next, event.y);
+}
+
+// Schedules the disappearance of the arc if its two breakpoints converge.
+void FortuneSweep::checkCircle(int arc, double sweep)
+{
+    int prev = m_arcs[arc].prev;
+    int next = m_arcs[arc].next;
+
+    if (prev < 0 || next < 0 || m_arcs[prev].site == m_arcs[next].site)
+        return;
+
+    const auto& a = m_sites[m_arcs[prev].site];
+    const auto& b = m_sites[m_arcs[arc].site];
+    const auto& c = m_sites[m_arcs[next].site];
+
+    Point ab = b - a;
+    Point ac = c - a;
+
+    // the breakpoints converge only if the three sites turn clockwise
+    double d = 2. * (ab ^ ac);
+    if (d >= 0.)
+        return;
+
+    double abLength = ab & ab;
+    double acLength = ac & ac;
+
+    Point offset{(ac.y * abLength - ab.y * acLength) / d, (ab.x * acLength - ac.x * abLength) / d};
+    Point center = a + offset;
+
+    double y = min(center.y - offset.mag(), sweep);
+
+    m_arcs[arc].event = m_eventCount;
+    m_events.push({y, center, arc, m_eventCount++});
+}
+
+int FortuneSweep::locate(const Point& p) const
+{
+    int arc = m_root;
+
+    while (true)
+    {
+        const auto& node = m_arcs[arc];
+        const auto& site = m_sites[node.site];
+
+        if (node.prev >= 0 && p.x < breakpoint(m_sites[m_arcs[node.prev].site], site, p.y))
+            arc = node.left;
+        else if (node.next >= 0 && p.x > breakpoint(site, m_sites[m_arcs[node.next].site], p.y))
+            arc = node.right;
+        else
+            return arc;
+    }
+}
+
+int FortuneSweep::newArc(int site)
+{
+    // xorshift32
+    m_random ^= m_random << 13;
+    m_random ^= m_random >> 17;
+    m_random ^= m_random << 5;
+
+    Arc arc{site, -1, -1, -1, m_random, -1, -1, -1, -1};
+
+    if (m_freeArcs.empty())
+    {
+        m_arcs.push_back(arc);
+        return m_arcs.size() - 1;
+    }
+
+    int index = m_freeArcs.back();
+    m_freeArcs.pop_back();
+    m_arcs[index] = arc;
+
+    return index;
+}
+
+void FortuneSweep::insertAfter(int arc, int newArc)
+{
+    auto& node = m_arcs[newArc];
+
+    node.prev = arc;
+    node.next = m_arcs[arc].next;
+    if (node.next >= 0)
+        m_arcs[node.next].prev = newArc;
+    else
+        m_tail = newArc;
+    m_arcs[arc].next = newArc;
+
+    // as the leftmost node of the right subtree, or the right child itself
+    int parent = arc;
+    if (m_arcs[parent].right < 0)
+    {
+        m_arcs[parent].right = newArc;
+    }
+    else
+    {
+        parent = m_arcs[parent].right;
+        while (m_arcs[parent].left >= 0)
+            parent = m_arcs[parent].left;
+        m_arcs[parent].left = newArc;
+    }
+    node.parent = parent;
+
+    while (m_arcs[newArc].parent >= 0 && m_arcs[m_arcs[newArc].parent].priority < m_arcs[newArc].priority)
+        rotateUp(newArc);
+}
+
+void FortuneSweep::erase(int arc)
+{
+    auto& node = m_arcs[arc];
+
+    if (node.prev >= 0)
+        m_arcs[node.prev].next = node.next;
+    if (node.next >= 0)
+        m_arcs[node.next].prev = node.prev;
+    else
+        m_tail = node.prev;
+
+    // rotate the node down until it has at most one child, then splice it out
+    while (node.left >= 0 && node.right >= 0)
+        rotateUp(m_arcs[node.left].priority > m_arcs[node.right].priority ? node.left : node.right);
+
+    int child = node.left >= 0 ? node.left : node.right;
+    int parent = node.parent;
+
+    if (child >= 0)
+        m_arcs[child].parent = parent;
+
+    if (parent < 0)
+        m_root = child;
+    else if (m_arcs[parent].left == arc)
+        m_arcs[parent].left = child;
+    else
+        m_arcs[parent].right = child;
+
+    node.event = -1;
+    m_freeArcs.push_back(arc);
+}
+
+void FortuneSweep::rotateUp(int arc)
+{
+    auto& node = m_arcs[arc];
+    int parent = node.parent;
+    auto& up = m_arcs[parent];
+    int grandParent = up.parent;
+
+    if (up.left == arc)
+    {
+        up.left = node.right;
+        if (node.right >= 0)
+            m_arcs[node.right].parent = parent;
+        node.right = parent;
+    }
+    else
+    {
+        up.right = node.left;
+        if (node.left >= 0)
+            m_arcs[node.left].parent = parent;
+        node.left = parent;
+    }
+
+    up.parent = arc;
+    node.parent = grandParent;
+
+    if (grandParent < 0)
+        m_root = arc;
+    else if (m_arcs[grandParent].left == parent)
+        m_arcs[grandParent].left = arc;
+    else
+        m_arcs[grandParent].right = arc;
+}
+
+int FortuneSweep::newEdge(int siteLeft, int siteRight)
+{
+    auto& halfEdges = m_out->halfEdges;
+    int h = halfEdges.size();
+
+    halfEdges.push_back({siteLeft, -1, h + 1, -1});
+    halfEdges.push_back({siteRight, -1, h, -1});
+
+    return h;
+}
+
+// Chains the half-edges of every cell: the successor of a half-edge is the
+// one of the same cell leaving its destination.
+void FortuneSweep::link(VoronoiDiagram& out)
+{
+    auto& halfEdges = out.halfEdges;
+
+    vector<int> offsets(m_sites.size() + 1, 0);
+    for (const auto& h : halfEdges)
+        ++offsets[h.site + 1];
+
+    partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+    vector<int> bySite(halfEdges.size());
+    vector<int> fill(offsets.begin(), offsets.end() - 1);
+    for (int h = 0; h < halfEdges.size(); ++h)
+        bySite[fill[halfEdges[h].site]++] = h;
+
+    for (int site = 0; site < m_sites.size(); ++site)
+    {
+        for (int i = offsets[site]; i < offsets[site + 1]; ++i)
+        {
+            auto& h = halfEdges[bySite[i]];
+
+            if (h.origin < 0 || out.cells[site] < 0)
+                out.cells[site] = bySite[i];
+
+            int destination = halfEdges[h.twin].origin;
+            if (destination < 0)
+                continue;
+
+            for (int j = offsets[site]; j < offsets[site + 1]; ++j)
+            {
+                if (halfEdges[bySite[j]].origin == destination)
+                {
+                    h.next = bySite[j];
+                    break;
+                }
+            }
+        }
+    }
+}
+
+// O(n * log(n)).
+void voronoiDiagram(const vector<Point>& sites, VoronoiDiagram& out)
+{
+    TRACE_SPAN("voronoiDiagram");
+
+    FortuneSweep sweep(sites);
+    sweep.run(out);
+}
+
+
+void checkVoronoi(const vector<Point>& sites, const VoronoiDiagram& diagram)
+{
+    const auto& halfEdges = diagram.halfEdges;
+
+    // planar graph with one vertex at infinity and one face per distinct site
+    int nCells = count_if(diagram.cells.begin(), diagram.cells.end(), [](int h) { return h >= 0; });
+    EXPECT_EQ(halfEdges.size() / 2, diagram.vertices.size() + nCells - 1);
+
+    for (int h = 0; h < halfEdges.size(); ++h)
+    {
+        const auto& edge = halfEdges[h];
+        ASSERT_EQ(halfEdges[edge.twin].twin, h);
+
+        int destination = halfEdges[edge.twin].origin;
+        if (edge.origin >= 0 && destination >= 0)
+        {
+            const auto& p = diagram.vertices[edge.origin];
+            const auto& q = diagram.vertices[destination];
+
+            // the cell lies on the left
+            ASSERT_GE((q - p) ^ (sites[edge.site] - p), -1e-9);
+        }
+
+        if (edge.next >= 0)
+        {
+            ASSERT_EQ(halfEdges[edge.next].origin, destination);
+            ASSERT_EQ(halfEdges[edge.next].site, edge.site);
+        }
+        else
+        {
+            ASSERT_EQ(destination, -1);
+        }
+    }
+
+    // every vertex is equidistant from the sites around it, and no site is closer
+    vector<double> radius(diagram.vertices.size(), -1.);
+    for (const auto& edge : halfEdges)
+    {
+        if (edge.origin < 0)
+            continue;
+
+        Point d = diagram.vertices[edge.origin] - sites[edge.site];
+        double r = d.mag();
+
+        if (radius[edge.origin] < 0.)
+            radius[edge.origin] = r;
+
+        ASSERT_NEAR(radius[edge.origin], r, 1e-7);
+    }
+
+    for (int v = 0; v < diagram.vertices.size(); ++v)
+    {
+        for (const auto& s : sites)
+        {
+            Point d = diagram.vertices[v] - s;
+            ASSERT_GE(d.mag(), radius[v] - 1e-7);
+        }
+    }
+
+    // walking a bounded cell returns to its first half-edge
+    for (int site = 0; site < sites.size(); ++site)
+    {
+        int start = diagram.cells[site];
+        if (start < 0 || halfEdges[start].origin < 0)
+            continue;
+
+        int h = start, steps = 0;
+        do
+        {
+            h = halfEdges[h].next;
+            ASSERT_LE(++steps, halfEdges.size());
+        } while (h != start);
+    }
+}
+
+TEST(voronoiDiagram, simple)
+{
+    vector<Point> sites = { {0, 0}, {4, 0}, {2, 3} };
+
+    VoronoiDiagram diagram;
+    voronoiDiagram(sites, diagram);
+
+    ASSERT_EQ(diagram.vertices.size(), 1);
+    EXPECT_EQ(diagram.halfEdges.size(), 6);
+    EXPECT_EQ(diagram.vertices[0], (Point{2, 5. / 6.}));
+    checkVoronoi(sites, diagram);
+
+    // the center site gets a bounded cell
+    sites = { {0, 0}, {4, 0}, {4, 4}, {0, 4}, {2, 1.9}, {2, 1.9} };
+    voronoiDiagram(sites, diagram);
+
+    checkVoronoi(sites, diagram);
+    EXPECT_EQ(diagram.cells[5], -1);
+
+    int h = diagram.cells[4], steps = 0;
+    do
+    {
+        ASSERT_GE(diagram.halfEdges[h].origin, 0);
+        h = diagram.halfEdges[h].next;
+        ++steps;
+    } while (h != diagram.cells[4]);
+    EXPECT_EQ(steps, 4);
+
+    // a first row of sites at equal height
+    sites = { {0, 0}, {1, 0}, {2, 0}, {1, -1} };
+    voronoiDiagram(sites, diagram);
+
+    EXPECT_EQ(diagram.vertices.size(), 2);
+    checkVoronoi(sites, diagram);
+}
+
+TEST(voronoiDiagram, random)
+{
+    mt19937 gen(11);
+    uniform_real_distribution<double> coordinate(-1., 1.);
+
+    vector<Point> sites(2000);
+    for (auto& p : sites)
+        p = {coordinate(gen), coordinate(gen)};
+
+    VoronoiDiagram diagram;
+    voronoiDiagram(sites, diagram);
+
+    checkVoronoi(sites, diagram);
+}
+
+TEST(voronoiDiagram, grid)
+{
+    // cocircular sites produce coincident vertices joined by zero-length edges
+    vector<Point> sites;
+    for (int i = 0; i < 20; ++i)
+        for (int j = 0; j < 20; ++j)
+            sites.push_back({double(i), double(j)});
+
+    VoronoiDiagram diagram;
+    voronoiDiagram(sites, diagram);
+
+    checkVoronoi(sites, diagram);
+}
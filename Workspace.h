@@ -0,0 +1,121 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory_resource>
+
+// Memory that a block was allocated with is handed back to upstream only by
+// release(); until then a freed block is kept and given out again for the
+// next request of the same size and alignment. Meant for the few large blocks
+// above the pool sizes, which are looked up linearly.
+class RetainingResource : public std::pmr::memory_resource
+{
+public:
+    explicit RetainingResource(std::pmr::memory_resource* upstream) :
+        m_upstream(upstream)
+    {
+    }
+
+    RetainingResource(const RetainingResource&) = delete;
+    RetainingResource& operator= (const RetainingResource&) = delete;
+
+    ~RetainingResource()
+    {
+        release();
+    }
+
+    void release()
+    {
+        while (m_free)
+        {
+            auto* block = m_free;
+            m_free = block->next;
+            m_upstream->deallocate(block, upstreamBytes(block->bytes), upstreamAlignment(block->alignment));
+        }
+    }
+
+private:
+    // kept in the freed block itself
+    struct FreeBlock
+    {
+        FreeBlock* next;
+        std::size_t bytes;
+        std::size_t alignment;
+    };
+
+    static std::size_t upstreamBytes(std::size_t bytes)
+    {
+        return std::max(bytes, sizeof(FreeBlock));
+    }
+
+    static std::size_t upstreamAlignment(std::size_t alignment)
+    {
+        return std::max(alignment, alignof(FreeBlock));
+    }
+
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        for (FreeBlock** b = &m_free; *b; b = &(*b)->next)
+        {
+            if ((*b)->bytes == bytes && (*b)->alignment == alignment)
+            {
+                auto* block = *b;
+                *b = block->next;
+                return block;
+            }
+        }
+
+        return m_upstream->allocate(upstreamBytes(bytes), upstreamAlignment(alignment));
+    }
+
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override
+    {
+        m_free = new (p) FreeBlock{m_free, bytes, alignment};
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+
+private:
+    std::pmr::memory_resource* m_upstream;
+    FreeBlock* m_free = nullptr;
+};
+
+// Scratch memory for repeated calls of the hull and sweep functions. The
+// overloads taking a Workspace build their temporary containers on
+// resource(), a pool that keeps every block it is given back; blocks above
+// the pool sizes are kept by size. Once calls on inputs of the sizes in use
+// have run, further calls take nothing from the heap. Outputs go to the
+// caller's vectors, which keep their capacity when reused.
+//
+// Not thread safe: one workspace per thread.
+class Workspace
+{
+public:
+    explicit Workspace(std::pmr::memory_resource* upstream = std::pmr::new_delete_resource()) :
+        m_retained(upstream),
+        m_pool(&m_retained)
+    {
+    }
+
+    Workspace(const Workspace&) = delete;
+    Workspace& operator= (const Workspace&) = delete;
+
+    std::pmr::memory_resource* resource()
+    {
+        return &m_pool;
+    }
+
+    // Hands all memory back to upstream.
+    void release()
+    {
+        m_pool.release();
+        m_retained.release();
+    }
+
+private:
+    RetainingResource m_retained;
+    std::pmr::unsynchronized_pool_resource m_pool;
+};